@@ -1,5 +1,7 @@
 #include <dice/eos.dice.hpp>
 #include <eosiolib/time.hpp>
+#include <algorithm>
+#include <cstring>
 
 using namespace eosio;
 
@@ -32,6 +34,30 @@ namespace
         return true;
     }
 
+    bool filter_deposit_transactions(eosio::name owner, const dice::tables::Config& cfg,
+            const common::tables::TokenTransfer& transfer)
+    {
+        if(transfer.from == owner ||
+            transfer.from == cfg.owner)
+        {
+            return false;
+        }
+        if(transfer.to != owner)
+        {
+            return false;
+        }
+        if(transfer.memo != "deposit")
+        {
+            return false;
+        }
+        auto& ref = transfer.quantity;
+        if(!ref.is_valid() || ref.symbol != common::EOS_SYMBOL || ref.amount <= 0)
+        {
+            return false;
+        }
+        return true;
+    }
+
     bool filter_replenishment_transactions(eosio::name owner, const dice::tables::Config& cfg,
             const common::tables::TokenTransfer& transfer)
     {
@@ -52,63 +78,267 @@ namespace
         return true;
     }
 
-    template<class T>
-    void add_bet_record(T& table, const eosio::name& payer, TableId& tbl_id, const eosio::name& player,
-            const eosio::asset& bet, const eosio::asset& reward, uint8_t roll_type, uint16_t roll_border,
-            uint16_t roll_value, const capi_checksum256& seed, const eosio::name& inviter)
+    void append_hex(std::string& str, const capi_checksum256& checksum)
+    {
+        static const char digits[] = "0123456789abcdef";
+        for(auto byte: checksum.hash)
+        {
+            str += digits[byte >> 4];
+            str += digits[byte & 0x0f];
+        }
+    }
+
+    /*
+     * writes record to ring table: rows are allocated once per slot and then overwritten in place,
+     * evicted(row) is called for every row before it is overwritten or removed
+     * */
+    template<class T, class F, class E>
+    uint64_t add_ring_record(T& table, const eosio::name& payer, TableId& tbl_id, RingLayout& layout, F&& fill,
+            E&& evicted)
     {
-        log("add_bet_record\n");
         auto id = tbl_id.next();
-        auto it = table.find(id);
+        auto slot = layout.slot(tbl_id, id);
+        auto it = table.find(slot);
         if(it == table.end())
         {
-            log("before emplace bet history\n");
+            LOG_DEBUG("before emplace ring record\n");
             table.emplace(payer, [&](auto& record)
             {
-                record.id = id;
-                record.player = player;
-                record.roll_type = roll_type;
-                record.roll_border = roll_border;
-                record.roll_value = roll_value;
-                record.bet = bet;
-                record.payout.push_back(reward);
-                record.seed = seed;
-                record.inviter = inviter;
-                record.time = eosio::time_point(eosio::seconds(now()));
+                record.slot = slot;
+                fill(record, id);
             });
         }
         else
         {
-            log("before modify bet history\n");
+            LOG_DEBUG("before modify ring record\n");
+            evicted(*it);
             table.modify(it, payer, [&](auto& record)
             {
-                record.id = id;
-                record.player = player;
-                record.roll_type = roll_type;
-                record.roll_border = roll_border;
-                record.roll_value = roll_value;
-                record.bet = bet;
-                record.payout.clear();
-                record.payout.push_back(reward);
-                record.seed = seed;
-                record.inviter = inviter;
-                record.time = eosio::time_point(eosio::seconds(now()));
+                fill(record, id);
             });
         }
-        // remove start record if current frame size > max
-        if(tbl_id.last - tbl_id.first + 1 > tbl_id.max)
+        // rows of ring before resize are removed in id order when they leave visible frame, up to two per insert
+        auto frame_first = id > tbl_id.max ? id - tbl_id.max + 1 : 1;
+        for(int i = 0; i < 2 && layout.has_old_rows() && layout.gc_next < frame_first; ++i)
         {
-            //just remove first by primary key
-            table.erase(table.begin());
-            ++tbl_id.first;
+            auto old_it = table.find(layout.old_base + layout.gc_next % layout.old_max);
+            if(old_it != table.end())
+            {
+                evicted(*old_it);
+                table.erase(old_it);
+            }
+            if(++layout.gc_next > layout.old_last)
+            {
+                layout.old_max = 0;
+            }
         }
+        tbl_id.first = layout.has_old_rows() ? layout.gc_next : frame_first;
+        return id;
+    }
+
+    /*
+     * moves ring to new slots, rows of current ring are removed by following inserts
+     * */
+    void resize_ring(TableId& tbl_id, RingLayout& layout, uint64_t size)
+    {
+        eosio_assert(size >= 1, "Bet history length must be greater than 0.");
+        eosio_assert(!layout.has_old_rows(), "Previous resize of bet history is not finished.");
+        eosio_assert(!layout.legacy, "Bet history must be migrated by bets.migrate.");
+        if(size == tbl_id.max)
+        {
+            return;
+        }
+        auto base = layout.base + tbl_id.max;
+        eosio_assert(size < TableId::ring_end - base, "Bet history length is too big.");
+        if(0 != tbl_id.last)
+        {
+            layout.old_base = layout.base;
+            layout.old_max = tbl_id.max;
+            layout.old_last = tbl_id.last;
+            layout.gc_next = tbl_id.first;
+        }
+        layout.base = base;
+        tbl_id.max = size;
+    }
+
+    uint64_t add_bet_record(Bets& table, const eosio::name& payer, TableId& tbl_id, RingLayout& layout,
+            const eosio::name& player, const eosio::asset& bet, const eosio::asset& reward, uint8_t roll_type,
+            uint16_t roll_border, uint16_t roll_value, const capi_checksum256& seed, uint16_t seed_word,
+            const eosio::name& inviter, uint8_t pins)
+    {
+        LOG_DEBUG("add_bet_record\n");
+        return add_ring_record(table, payer, tbl_id, layout, [&](auto& record, uint64_t id)
+        {
+            record.id = id;
+            record.version = Bet::current_version;
+            record.pins = pins;
+            record.player = player;
+            record.roll_type = roll_type;
+            record.roll_border = roll_border;
+            record.roll_value = roll_value;
+            record.bet = bet.amount;
+            record.payout = reward.amount;
+            record.seed = seed;
+            record.seed_word = seed_word;
+            record.inviter = inviter;
+            record.time = eosio::time_point(eosio::seconds(now()));
+        },
+        [&](const Bet& row)
+        {
+            if(0 != row.pins)
+            {
+                // bet is referenced from bets.high or bets.rare, keep it out of ring
+                LOG_DEBUG("before pin bet %\n", row.id);
+                auto pinned = row;
+                pinned.slot = Bet::pinned_slot(row.id);
+                table.emplace(payer, [&](auto& record)
+                {
+                    record = pinned;
+                });
+            }
+        });
+    }
+
+    void unpin_bet(Bets& table, const eosio::name& payer, const TableId& tbl_id, const RingLayout& layout,
+            uint64_t bet_id, uint8_t pin)
+    {
+        auto it = table.find(Bet::pinned_slot(bet_id));
+        if(it == table.end())
+        {
+            it = table.find(layout.slot(tbl_id, bet_id));
+            if(it == table.end() || it->id != bet_id)
+            {
+                return;
+            }
+        }
+        if(it->slot >= TableId::ring_end && 0 == (it->pins & ~pin))
+        {
+            LOG_DEBUG("before remove pinned bet %\n", bet_id);
+            table.erase(it);
+        }
+        else if(0 != (it->pins & pin))
+        {
+            table.modify(it, payer, [&](auto& record)
+            {
+                record.pins &= ~pin;
+            });
+        }
+    }
+
+    template<class T>
+    void add_bet_ref(T& table, Bets& bets, const eosio::name& payer, TableId& tbl_id, RingLayout& layout,
+            const TableId& bets_id, const RingLayout& bets_layout, uint64_t bet_id, uint64_t sort_key, uint8_t pin)
+    {
+        LOG_DEBUG("add_bet_ref\n");
+        add_ring_record(table, payer, tbl_id, layout, [&](auto& record, uint64_t)
+        {
+            record.bet_id = bet_id;
+            record.sort_key = sort_key;
+        },
+        [&](const BetRef& row)
+        {
+            unpin_bet(bets, payer, bets_id, bets_layout, row.bet_id, pin);
+        });
+    }
+
+    void convert_legacy_bet(const LegacyBet& legacy, Bet& record, bool keep_seed)
+    {
+        record.id = legacy.id;
+        record.version = Bet::current_version;
+        record.pins = 0;
+        record.player = legacy.player;
+        record.roll_type = legacy.roll_type;
+        record.roll_border = legacy.roll_border;
+        record.roll_value = legacy.roll_value;
+        record.bet = legacy.bet.amount;
+        record.payout = legacy.payout.empty() ? 0 : legacy.payout.front().amount;
+        record.inviter = legacy.inviter;
+        if(keep_seed)
+        {
+            record.seed = legacy.seed;
+        }
+        record.seed_word = 0;
+        record.time = legacy.time;
+    }
+
+    /*
+     * legacy rows are keyed by id and were kept up to the last max ids,
+     * rows of the frame are moved to the ring, older ones are dropped
+     * returns next id to migrate, or max of uint64_t when table is migrated
+     * */
+    template<class L, class F>
+    uint64_t migrate_history(L& legacy, TableId& tbl_id, uint64_t from_id, uint16_t count, F&& move)
+    {
+        auto frame_first = tbl_id.last > tbl_id.max ? tbl_id.last - tbl_id.max + 1 : 1;
+        auto id = std::max(from_id, tbl_id.first);
+        for(; id <= tbl_id.last && count > 0; ++id, --count)
+        {
+            auto it = legacy.find(id);
+            if(it == legacy.end())
+            {
+                continue;
+            }
+            auto legacy_record = *it;
+            // erase by object, erase by iterator reads next row which can be in new format
+            legacy.erase(*it);
+            if(id >= frame_first)
+            {
+                move(legacy_record);
+            }
+        }
+        if(id > tbl_id.last)
+        {
+            tbl_id.first = std::max(tbl_id.first, frame_first);
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return id;
+    }
+
+    uint64_t migrate_bet_records(LegacyBets& legacy, Bets& table, const eosio::name& payer, TableId& tbl_id,
+            const RingLayout& layout, uint64_t from_id, uint16_t count)
+    {
+        return migrate_history(legacy, tbl_id, from_id, count, [&](const LegacyBet& legacy_record)
+        {
+            table.emplace(payer, [&](auto& record)
+            {
+                convert_legacy_bet(legacy_record, record, true);
+                record.slot = layout.slot(tbl_id, legacy_record.id);
+            });
+        });
+    }
+
+    /*
+     * legacy bets.high and bets.rare rows are full copies of bets, they become pinned bets of bets.all
+     * */
+    template<class L, class T>
+    uint64_t migrate_bet_refs(L& legacy, T& table, Bets& bets, const eosio::name& payer, TableId& tbl_id,
+            const RingLayout& layout, uint64_t from_id, uint16_t count, uint8_t pin)
+    {
+        return migrate_history(legacy, tbl_id, from_id, count, [&](const LegacyBet& legacy_record)
+        {
+            auto bet_id = Bet::legacy_ref_id(legacy_record.id, pin);
+            bets.emplace(payer, [&](auto& record)
+            {
+                convert_legacy_bet(legacy_record, record, false);
+                record.id = bet_id;
+                record.slot = Bet::pinned_slot(bet_id);
+                record.pins = pin;
+            });
+            table.emplace(payer, [&](auto& record)
+            {
+                record.slot = layout.slot(tbl_id, legacy_record.id);
+                record.bet_id = bet_id;
+                record.sort_key = pin == Bet::PIN_HIGH ? legacy_record.bet.amount
+                        : (legacy_record.payout.empty() ? 0 : legacy_record.payout.front().amount);
+            });
+        });
     }
 
     void update_player_bets_statistics(dice::tables::PlayerBetsStatistics& stats, const eosio::asset& bet,
             const eosio::asset& reward, eosio::time_point last_bet_time = eosio::time_point(eosio::seconds(0)),
             uint32_t period_in_sec = 0)
     {
-        log("update_player_bets_statistics(%, %)\n", bet, reward);
+        LOG_DEBUG("update_player_bets_statistics(%, %)\n", bet, reward);
         if(0 != period_in_sec)
         {
             // 0 means non resetable statistics
@@ -130,110 +360,227 @@ namespace
         }
     }
 
-    auto update_player_statistics(dice::tables::Config& config, dice::tables::Players& table, const eosio::name& player,
-            const eosio::asset& bet, const eosio::asset& reward)
+    dice::tables::Player create_player(const eosio::name& account)
+    {
+        dice::tables::Player p;
+        p.account = account;
+        p.last_bet_time = eosio::time_point(eosio::seconds(0));
+        p.last_bet = eosio::asset(0, common::EOS_SYMBOL);
+        p.last_payout = eosio::asset(0, common::EOS_SYMBOL);
+        p.jackpot_sequence = -1;
+        p.jackpot_sequence_values = "";
+        p.total.reset();
+        p.day.reset();
+        p.week.reset();
+        p.month.reset();
+        return p;
+    }
+
+    void update_player_statistics(dice::tables::Player& p, const eosio::asset& bet, const eosio::asset& reward)
     {
         // reset obsolete
-        auto it = table.find(player.value);
-        if(table.end() == it)
+        auto previous_bet_time = p.last_bet_time;
+        update_player_bets_statistics(p.total, bet, reward);
+        update_player_bets_statistics(p.day, bet, reward, previous_bet_time, one_day_in_seconds);
+        update_player_bets_statistics(p.week, bet, reward, previous_bet_time, one_week_in_seconds);
+        update_player_bets_statistics(p.month, bet, reward, previous_bet_time, one_month_in_seconds);
+        p.last_bet_time = eosio::time_point(eosio::seconds(now()));
+        p.last_bet = bet;
+        p.last_payout = reward;
+    }
+
+    /*
+     * rows of ante.bonuses written before bonus.set validated them can overlap,
+     * they were looked up by first match in begin order, so overlapped parts of later rows are cut off
+     * */
+    dice::tables::AnteBonusTiers build_bonus_tiers(const dice::tables::AnteBonusesConfig& table)
+    {
+        dice::tables::AnteBonusTiers result;
+        for (auto& row: table)
         {
-            log("before emplace player statistics\n");
-            it = table.emplace(config.owner, [&](auto& p)
+            auto tier = row;
+            if(!result.tiers.empty() && result.tiers.back().end >= tier.begin)
             {
-                p.account = player;
-                p.total.reset();
-                p.day.reset();
-                p.week.reset();
-                p.month.reset();
-                p.jackpot_sequence = -1;
-                p.jackpot_sequence_values = "";
-                update_player_bets_statistics(p.total, bet, reward);
-                update_player_bets_statistics(p.day, bet, reward);
-                update_player_bets_statistics(p.week, bet, reward);
-                update_player_bets_statistics(p.month, bet, reward);
-                p.last_bet_time = eosio::time_point(eosio::seconds(now()));
-                p.last_bet = bet;
-                p.last_payout = reward;
-            });
-        }
-        else
-        {
-            log("before modify player statistics\n");
-            auto previous_bet_time = it->last_bet_time;
-            table.modify(it, config.owner, [&](auto& p)
+                if(result.tiers.back().end >= tier.end)
+                {
+                    continue;
+                }
+                tier.begin = result.tiers.back().end + 1;
+            }
+            if(tier.begin <= tier.end)
             {
-                //update statistics
-                update_player_bets_statistics(p.total, bet, reward);
-                update_player_bets_statistics(p.day, bet, reward, previous_bet_time, one_day_in_seconds);
-                update_player_bets_statistics(p.week, bet, reward, previous_bet_time, one_week_in_seconds);
-                update_player_bets_statistics(p.month, bet, reward, previous_bet_time, one_month_in_seconds);
-                p.last_bet_time = eosio::time_point(eosio::seconds(now()));
-                p.last_bet = bet;
-                p.last_payout = reward;
-            });
+                result.tiers.push_back(tier);
+            }
         }
-        return it;
+        return result;
     }
 
-    double get_bonus_multiplier(const dice::tables::AnteBonusesConfig& table,
+    void validate_bonus_tier(const dice::tables::AnteBonusesConfig& table, uint16_t begin, uint16_t end)
+    {
+        eosio_assert(begin <= end, "Wrong bonus tier bounds.");
+        auto next = table.upper_bound(begin);
+        eosio_assert(next == table.end() || next->begin > end, "Bonus tiers overlap.");
+        auto previous = table.lower_bound(begin);
+        eosio_assert(previous == table.begin() || (--previous)->end < begin, "Bonus tiers overlap.");
+    }
+
+    double get_bonus_multiplier(const dice::tables::AnteBonusTiers& bonuses,
             const dice::tables::PlayerBetsStatistics& day_stats)
     {
-        auto bets_count = day_stats.bets;
-        for (auto& row: table )
-        {
-            if(row.begin <= bets_count && bets_count <= row.end)
-            {
-                return row.multiplier;
-            }
-        }
-        return 1.0;
+        return dice::rules::bonus_multiplier(bonuses.tiers.begin(), bonuses.tiers.end(), day_stats.bets);
+    }
+
+    dice::tables::PayoutTable build_payout_table(const dice::tables::DiceLimit& limits)
+    {
+        dice::tables::PayoutTable result;
+        result.multipliers = dice::rules::payout_multipliers(limits.platform_fee, limits.max_bet_num, limits.max_value);
+        return result;
+    }
+
+    bool is_equal(const capi_checksum256& lhs, const capi_checksum256& rhs)
+    {
+        return 0 == std::memcmp(lhs.hash, rhs.hash, sizeof(lhs.hash));
+    }
+
+    bool is_empty(const capi_checksum256& checksum)
+    {
+        return is_equal(checksum, capi_checksum256{});
+    }
+
+    dice::tables::ResolveConfig default_resolve_config()
+    {
+        return dice::tables::ResolveConfig{ResolveMode::DEFERRED, capi_checksum256{},
+                ResolveConfig::default_reveal_timeout, 0};
     }
 
 }
 
 namespace dice {
+namespace tables {
+
+uint64_t Player::by_day_bets()const
+{
+    return period_key(period_number(last_bet_time, config::one_day_in_seconds), day.total_bet_amount);
+}
+
+uint64_t Player::by_day_bets_count()const
+{
+    return period_key(period_number(last_bet_time, config::one_day_in_seconds), day.bets);
+}
+
+uint64_t Player::by_week_bets()const
+{
+    return period_key(period_number(last_bet_time, config::one_week_in_seconds), week.total_bet_amount);
+}
+
+uint64_t Player::by_week_bets_count()const
+{
+    return period_key(period_number(last_bet_time, config::one_week_in_seconds), week.bets);
+}
+
+uint64_t Player::by_month_bets()const
+{
+    return period_key(period_number(last_bet_time, config::one_month_in_seconds), month.total_bet_amount);
+}
+
+uint64_t Player::by_month_bets_count()const
+{
+    return period_key(period_number(last_bet_time, config::one_month_in_seconds), month.bets);
+}
+
+}//namespace tables
 
 Dice::Dice(eosio::name receiver, eosio::name code, eosio::datastream<const char*> ds)
         : contract(receiver, code, ds),
           _globalConfig(_self, _self.value),
+          _contractState(_self, _self.value),
+          _contractSettings(_self, _self.value),
           _diceLimits(_self, _self.value),
           _betTokens(_self, common::EOS_SYMBOL.raw()),
           _bonusesConfig(_self, _self.value),
+          _bonusTiersConfig(_self, _self.value),
+          _payoutTableConfig(_self, _self.value),
           _bets(_self, _self.value),
           _highBets(_self, _self.value),
           _rareBets(_self, _self.value),
           _players(_self, _self.value),
           _jackpots(_self, _self.value),
+          _resolveConfig(_self, _self.value),
+          _pendingBets(_self, _self.value),
+          _balances(_self, _self.value),
+          _pendingMints(_self, _self.value),
           _referrals(_self),
           _leaderBoards(_self, _stateConfig)
 {
-    log("Dice Constructor started\n");
-    if (!_globalConfig.exists())
+    LOG_DEBUG("Dice Constructor started\n");
+    if (_contractState.exists())
+    {
+        _stateConfig.set_state(_contractState.get());
+        _stateConfig.set_settings(_contractSettings.get());
+        _loadedConfig = _stateConfig;
+        _stateLimits = _loadedLimits = _diceLimits.get();
+        _stateEosToken = _loadedEosToken = _betTokens.get();
+    }
+    else if (!_globalConfig.exists())
     {//on first call
         _stateConfig = config::init_main_config(_self);
+        // init_main_config does not know ring layouts
+        _stateConfig.bets_layout = RingLayout::start(0, false);
+        _stateConfig.high_bets_layout = RingLayout::start(0, false);
+        _stateConfig.rare_bets_layout = RingLayout::start(0, false);
         _stateLimits = config::init_dice_limits();
         _stateEosToken = config::init_bet_token();
+        update_payout_table();
         config::init_ante_bonuses(_self, _bonusesConfig);
+        _bonusTiersConfig.set(build_bonus_tiers(_bonusesConfig), _self);
+        _isNewState = true;
     }
     else
     {
-        _stateConfig = _globalConfig.get();
-        _stateLimits = _diceLimits.get();
-        _stateEosToken = _betTokens.get();
+        _isLegacyConfig = true;
+        _stateConfig = _loadedConfig = _globalConfig.get();
+        _stateLimits = _loadedLimits = _diceLimits.get();
+        _stateEosToken = _loadedEosToken = _betTokens.get();
     }
     _referrals.setBonusMultiplier(_stateConfig.referral_multiplier);
     _leaderBoards.refresh();
 
-    log("Dice Constructor finished\n");
+    LOG_DEBUG("Dice Constructor finished\n");
 }
 
 Dice::~Dice()
 {
-    log("Dice destructor started\n");
-    _globalConfig.set(_stateConfig, _self);
-    _diceLimits.set(_stateLimits, _self);
-    _betTokens.set(_stateEosToken, _self);
-    log("Dice destructor finished\n");
+    LOG_DEBUG("Dice destructor started\n");
+    flush_payouts();
+    // write back only singletons which were changed by the action
+    if(_isLegacyConfig)
+    {
+        if(_stateConfig != _loadedConfig)
+        {
+            _globalConfig.set(_stateConfig, _self);
+        }
+    }
+    else
+    {
+        // hot state is written by bets, settings only when they are changed
+        if(_isNewState || _stateConfig.get_state() != _loadedConfig.get_state())
+        {
+            _contractState.set(_stateConfig.get_state(), _self);
+        }
+        if(_isNewState || _stateConfig.get_settings() != _loadedConfig.get_settings())
+        {
+            _contractSettings.set(_stateConfig.get_settings(), _self);
+        }
+    }
+    if(_isNewState || _stateLimits != _loadedLimits)
+    {
+        _diceLimits.set(_stateLimits, _self);
+    }
+    if(_isNewState || _stateEosToken != _loadedEosToken)
+    {
+        _betTokens.set(_stateEosToken, _self);
+    }
+    LOG_DEBUG("Dice destructor finished\n");
 }
 
 void Dice::setAdmin(eosio::name caller, eosio::name admin)
@@ -279,6 +626,7 @@ void Dice::setGameParams(eosio::name caller, uint16_t min, uint16_t max, uint16_
     _stateLimits.min_value = min;
     _stateLimits.max_value= max;
     _stateLimits.max_bet_num = max_bet_num;
+    update_payout_table();
 }
 
 void Dice::setMinBet(eosio::name caller, eosio::asset min_bet)
@@ -305,6 +653,7 @@ void Dice::setPlatformFee(eosio::name caller, double platform_fee)
     eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
     eosio_assert(platform_fee > 0, "Wrong exchange rate");
     _stateLimits.platform_fee = platform_fee;
+    update_payout_table();
 }
 
 void Dice::setBalanceValue(eosio::name caller, eosio::asset balance)
@@ -339,56 +688,63 @@ void Dice::setBetsHistoryLength(eosio::name caller, uint64_t size)
 {
     require_auth(caller);
     eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
-    eosio_assert(size >= 1, "Bet history length must be greater than 0.");
-    _stateConfig.bets_id.max = size;
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    resize_ring(_stateConfig.bets_id, _stateConfig.bets_layout, size);
 }
 
 void Dice::setRareBetsHistoryLength(eosio::name caller, uint64_t size)
 {
     require_auth(caller);
     eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
-    eosio_assert(size >= 1, "Bet history length must be greater than 0.");
-    _stateConfig.rare_bets_id.max = size;
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    resize_ring(_stateConfig.rare_bets_id, _stateConfig.rare_bets_layout, size);
 }
 
 void Dice::setHighBetsHistoryLength(eosio::name caller, uint64_t size)
 {
     require_auth(caller);
     eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
-    eosio_assert(size >= 1, "Bet history length must be greater than 0.");
-    _stateConfig.high_bets_id.max = size;
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    resize_ring(_stateConfig.high_bets_id, _stateConfig.high_bets_layout, size);
 }
 
 uint8_t Dice::get_winners(uint8_t roll_type, uint16_t roll_border)
 {
-    uint8_t num;
-    if (roll_type == RollType::LEFT)
-    {
-        num = roll_border;
-    }
-    else if (roll_type == RollType::RIGHT)
-    {
-        num = _stateLimits.max_bet_num - 1 - roll_border;
-    }
-    return num;
+    return rules::winners(roll_type == RollType::LEFT, roll_border, _stateLimits.max_bet_num);
 }
 
 eosio::asset Dice::get_bet_reward(uint8_t roll_type, uint16_t roll_border, const eosio::asset& quantity)
 {
     auto num = get_winners(roll_type, roll_border);
-    eosio_assert(num != 0, "Wrong configuration: _stateLimits.max_bet_num = 1 + roll_border");
-    auto reward = eosio::asset{
-        int64_t(quantity.amount * (1 - _stateLimits.platform_fee) * (100.0 / num)),
-        common::EOS_SYMBOL
-    };
-    log("DEBUG: quantity=%, num=%, %, %, %, %\n", quantity, num,
-            (1 - _stateLimits.platform_fee),
-            (100 / num),
-            (1 - _stateLimits.platform_fee) * (100.0 / num),
-            reward);
+    auto& multipliers = get_payout_table().multipliers;
+    eosio_assert(num != 0 && num < multipliers.size(), "Wrong configuration: no payout multiplier for roll border.");
+    auto reward = eosio::asset{rules::reward(quantity.amount, multipliers[num]), common::EOS_SYMBOL};
+    LOG_DEBUG("quantity=%, num=%, multiplier=%, %\n", quantity, num, multipliers[num], reward);
     return reward;
 }
 
+const tables::PayoutTable& Dice::get_payout_table()
+{
+    if(!_statePayoutTable)
+    {
+        if(_payoutTableConfig.exists())
+        {
+            _statePayoutTable = _payoutTableConfig.get();
+        }
+        else
+        {
+            update_payout_table();
+        }
+    }
+    return *_statePayoutTable;
+}
+
+void Dice::update_payout_table()
+{
+    _statePayoutTable = build_payout_table(_stateLimits);
+    _payoutTableConfig.set(*_statePayoutTable, _self);
+}
+
 void Dice::on_replenishment(const common::tables::TokenTransfer& data)
 {
     _stateConfig.eos_balance += data.quantity;
@@ -406,58 +762,90 @@ void Dice::notify(std::string)
 
 void Dice::on_bet(const common::tables::TokenTransfer& data)
 {
-    log("on_bet\n");
-    _stateConfig.eos_balance += data.quantity;
+    LOG_DEBUG("on_bet\n");
+    place_bet(data.from, data.quantity, memo::parse_bet(data.memo), false);
+}
+
+void Dice::on_deposit(const common::tables::TokenTransfer& data)
+{
+    LOG_DEBUG("on_deposit(%, %)\n", data.from, data.quantity);
+    auto it = _balances.find(data.from.value);
+    if(it == _balances.end())
+    {
+        // notification cannot bill player for RAM, new row is paid by contract only for a real stake
+        eosio_assert(data.quantity >= _stateLimits.min_bet, "Deposit must be >= min_bet.");
+        _balances.emplace(_self, [&](auto& record)
+        {
+            record.player = data.from;
+            record.balance = data.quantity;
+        });
+    }
+    else
+    {
+        _balances.modify(it, eosio::same_payer, [&](auto& record)
+        {
+            record.balance += data.quantity;
+        });
+    }
+}
+
+void Dice::place_bet(const eosio::name& player, const eosio::asset& total, const memo::BetMemo& bet_memo,
+        bool is_session)
+{
+    // bet of legacy config would be accepted here and fail when it is resolved
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    eosio_assert(_stateConfig.is_history_migrated(), "Bet history must be migrated by bets.migrate.");
+    _stateConfig.eos_balance += total;
     eosio_assert(_stateConfig.eos_balance >= _stateLimits.balance_protect, "Game under maintain, stay tuned.");
-    eosio_assert(data.quantity.amount <= _stateConfig.eos_balance.amount * _stateLimits.max_bet_percent,
+    eosio_assert(total.amount <= _stateConfig.eos_balance.amount * _stateLimits.max_bet_percent,
                  "Bet amount exceeds max amount.");
 
-    std::vector <std::string> pieces;
-    common::split(data.memo, pieces, ",");
-    eosio_assert(pieces.size() >= 3, "Wrong memo parameter.");
-    eosio_assert(!pieces[1].empty(), "Roll type cannot be empty!");
-    eosio_assert(!pieces[2].empty(), "Roll prediction cannot be empty!");
-
-    uint8_t roll_type = atoi(pieces[1].c_str());
+    auto roll_type = bet_memo.roll_type;
     eosio_assert(roll_type == RollType::LEFT || roll_type == RollType::RIGHT, "Unsupported roll type.");
 
-    uint16_t roll_border = atoi(pieces[2].c_str());
+    auto roll_border = bet_memo.roll_border;
     if (roll_type == RollType::LEFT) {
         eosio_assert(roll_border <= _stateLimits.max_value, "Bet border must be <= MAX value.");
     } else if (roll_type == RollType::RIGHT) {
         eosio_assert(roll_border >= _stateLimits.min_value, "Bet border must >= MIN value.");
     }
 
-    eosio::name inviter;
-    if ((pieces.size() == 2) || pieces[3].empty())
-    {
-        //use the same account as better
-        inviter = data.from;
-    }
-    else
-    {
-        inviter = eosio::name(pieces[3]);
-    }
+    //use the same account as better if memo has no inviter
+    auto inviter = bet_memo.inviter ? bet_memo.inviter : player;
 
-    eosio_assert(data.quantity >= _stateLimits.min_bet, "Bet must be >= min_bet.");
-    auto max_possible_reward = get_bet_reward(roll_type, roll_border, data.quantity);
+    // transferred amount is split into equal rolls
+    auto rolls = bet_memo.rolls;
+    eosio_assert(total.amount % rolls == 0, "Bet amount must be divisible by rolls count.");
+    auto quantity = eosio::asset{total.amount / rolls, total.symbol};
+
+    eosio_assert(quantity >= _stateLimits.min_bet, "Bet must be >= min_bet.");
+    auto max_possible_reward = get_bet_reward(roll_type, roll_border, quantity);
+    max_possible_reward.amount *= rolls;
 
     std::string msg = "Bet reward must be between ";
     msg += _stateLimits.min_bet.to_string();
     msg += " and ";
     msg += max_possible_reward.to_string();
     eosio_assert(max_possible_reward.amount <= (_stateConfig.eos_balance.amount * _stateLimits.max_bet_percent), msg.c_str());
-    log("DEBUG: before call bet(%,%,%,%,%)\n", data.from, inviter, data.quantity, roll_type, roll_border);
+    auto resolve = _resolveConfig.get_or_default(default_resolve_config());
+    if(resolve.mode == ResolveMode::REVEAL || resolve.mode == ResolveMode::BATCH)
+    {
+        enqueue_bet(player, inviter, quantity, roll_type, roll_border, rolls, is_session, resolve);
+        return;
+    }
+
+    LOG_DEBUG("before call bet(%,%,%,%,%,%)\n", player, inviter, quantity, roll_type, roll_border, rolls);
     eosio::transaction deferred;
     deferred.actions.emplace_back(
             permission_level{_self, "active"_n},
             _self, "bet"_n,
             std::make_tuple(
-                    data.from,
+                    player,
                     inviter,
-                    data.quantity,
+                    quantity,
                     roll_type,
-                    roll_border
+                    roll_border,
+                    rolls
             )
     );
     uint128_t deferred_id = _stateConfig.next_deferred_id(TransactionNumber::BET);
@@ -467,7 +855,7 @@ void Dice::on_bet(const common::tables::TokenTransfer& data)
 
 void Dice::on_error(eosio::onerror& error)
 {
-    log("on_error(eosio::onerror& error)\n");
+    LOG_DEBUG("on_error(eosio::onerror& error)\n");
     auto error_trx = error.unpack_sent_trx();
     std::string msg = "Action(s) failed: ";
     for(auto& action : error_trx.actions)
@@ -481,15 +869,15 @@ void Dice::on_error(eosio::onerror& error)
         }
         else if(action.name == "bet"_n)
         {
-            log("ERROR: `bet` action failed\n");
+            LOG_ERROR("`bet` action failed\n");
         }
         else if(action.name == "resolved"_n)
         {
-            log("ERROR: `resolved` action failed\n");
+            LOG_ERROR("`resolved` action failed\n");
         }
         else if(action.name == "mint"_n)
         {
-            log("ERROR: `mint` action failed\n");
+            LOG_ERROR("`mint` action failed\n");
         }
     }
 
@@ -503,33 +891,42 @@ void Dice::on_error(eosio::onerror& error)
 
 void Dice::on_transfer()
 {
-    log("on_transfer catched\n");
+    LOG_DEBUG("on_transfer catched\n");
     /*
      possible memo format:
      1. starts from bet
         bet,roll_type,roll_value,inviter   - bet with inviter
         bet,roll_type,roll_value           - bet without inviter
+        bet,roll_type,roll_value,inviter,xN - N rolls of amount/N, inviter may be empty
 
-     2. any other memo means "balance replenishment"
+     2. deposit
+        increase player balance which is used by bet.session
+
+     3. any other memo means "balance replenishment"
         just increase eos_balance
      */
     auto data = unpack_action_data<common::tables::TokenTransfer>();
     if (filter_bet_transactions(_self, _stateConfig, data))
     {
-        log("filtered bet transaction\n");
+        LOG_DEBUG("filtered bet transaction\n");
         on_bet(data);
     }
+    else if (filter_deposit_transactions(_self, _stateConfig, data))
+    {
+        LOG_DEBUG("filtered deposit transaction\n");
+        on_deposit(data);
+    }
     else if (filter_replenishment_transactions(_self, _stateConfig, data))
     {
-        log("filtered incoming transaction\n");
+        LOG_DEBUG("filtered incoming transaction\n");
         on_replenishment(data);
     }
 }
 
 void Dice::makeBet(eosio::name player, eosio::name inviter, eosio::asset quantity, uint8_t roll_type,
-        uint16_t roll_border)
+        uint16_t roll_border, uint8_t rolls)
 {
-    log("makeBet(%,%,%,%,%)\n", player, inviter, quantity, roll_type, roll_border);
+    LOG_DEBUG("makeBet(%,%,%,%,%,%)\n", player, inviter, quantity, roll_type, roll_border, rolls);
     require_auth(_self);
     if(_stateConfig.enabled_betting)
     {
@@ -542,7 +939,8 @@ void Dice::makeBet(eosio::name player, eosio::name inviter, eosio::asset quantit
                         inviter,
                         quantity,
                         roll_type,
-                        roll_border
+                        roll_border,
+                        rolls
                 )
         );
         deferred.delay_sec = 2;
@@ -553,54 +951,95 @@ void Dice::makeBet(eosio::name player, eosio::name inviter, eosio::asset quantit
 
 void Dice::pay_for_win(const eosio::name& player, const eosio::asset& quantity, std::string& message)
 {
-    log("pay_for_win(%, %)\n", player, quantity);
-    log("DEBUG: win -> %\n", message.c_str());
-    if(_stateConfig.enabled_payout)
+    LOG_DEBUG("pay_for_win(%, %)\n", player, quantity);
+    LOG_DEBUG("win -> %\n", message.c_str());
+    auto it = std::find_if(_payouts.begin(), _payouts.end(), [&](const auto& payout)
     {
-        action(
-                permission_level{_self, "active"_n},
-                "eosio.token"_n,
-                "transfer"_n,
-                std::make_tuple(
-                        _stateConfig.owner,
-                        player,
-                        quantity,
-                        message
-                )
-        ).send();
+        return payout.player == player;
+    });
+    if(it == _payouts.end())
+    {
+        _payouts.push_back(Payout{player, quantity, message, 1});
+    }
+    else
+    {
+        it->quantity += quantity;
+        ++it->count;
     }
     _stateConfig.eos_balance -= quantity;
     _stateConfig.total_payout += quantity;
     _stateEosToken.out += quantity.amount;
 }
 
-void Dice::register_bet(const eosio::name& player, const eosio::asset& bet, const eosio::asset& reward,
+void Dice::flush_payouts()
+{
+    for(auto& payout: _payouts)
+    {
+        LOG_DEBUG("flush_payouts(%, %, %)\n", payout.player, payout.quantity, payout.count);
+        auto balance_it = _balances.find(payout.player.value);
+        if(balance_it != _balances.end())
+        {
+            // player has prepaid balance: winnings stay in contract until withdraw
+            _balances.modify(balance_it, eosio::same_payer, [&](auto& record)
+            {
+                record.balance += payout.quantity;
+            });
+        }
+        else if(_stateConfig.enabled_payout)
+        {
+            if(payout.count > 1)
+            {
+                payout.message = "Total of " + std::to_string(payout.count) + " payouts. " + payout.message;
+            }
+            action(
+                    permission_level{_self, "active"_n},
+                    "eosio.token"_n,
+                    "transfer"_n,
+                    std::make_tuple(
+                            _stateConfig.owner,
+                            payout.player,
+                            payout.quantity,
+                            payout.message
+                    )
+            ).send();
+        }
+    }
+    _payouts.clear();
+}
+
+void Dice::register_bet(tables::Player& player_row, const eosio::asset& bet, const eosio::asset& reward,
         uint8_t roll_type, uint16_t roll_border, uint16_t roll_value, const eosio::name& inviter)
 {
-    log("register_bet(%, %, %, %, %, %, %)\n",
+    const auto& player = player_row.account;
+    LOG_DEBUG("register_bet(%, %, %, %, %, %, %)\n",
             player, bet, reward, roll_type, roll_border, roll_value, inviter);
 
-    log("DEBUG: store record to bets.all\n");
-    add_bet_record(_bets, _self, _stateConfig.bets_id, player, bet, reward, roll_type, roll_border, roll_value,
-            _seed, inviter);
+    bool is_high = bet >= _stateConfig.high_bet_bound;
+    auto num = get_winners(roll_type, roll_border);
+    bool is_rare = reward.amount > 0 && num <= _stateConfig.rare_bet_bound;
+    uint8_t pins = (is_high ? Bet::PIN_HIGH : 0) | (is_rare ? Bet::PIN_RARE : 0);
+
+    // ring layouts are stored only in cfg.state
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    LOG_DEBUG("store record to bets.all\n");
+    auto bet_id = add_bet_record(_bets, _self, _stateConfig.bets_id, _stateConfig.bets_layout, player, bet, reward,
+            roll_type, roll_border, roll_value, _seed, _seedWord, inviter, pins);
 
-    log("DEBUG: store record to bets.high\n");
-    if(bet >= _stateConfig.high_bet_bound)
+    if(is_high)
     {
-        add_bet_record(_highBets, _self, _stateConfig.high_bets_id, player, bet, reward, roll_type, roll_border,
-                       roll_value, _seed, inviter);
+        LOG_DEBUG("store reference to bets.high\n");
+        add_bet_ref(_highBets, _bets, _self, _stateConfig.high_bets_id, _stateConfig.high_bets_layout,
+                _stateConfig.bets_id, _stateConfig.bets_layout, bet_id, bet.amount, Bet::PIN_HIGH);
     }
-    log("DEBUG: store record to bets.rare\n");
-    auto num = get_winners(roll_type, roll_border);
-    if(reward.amount > 0 && num <= _stateConfig.rare_bet_bound)
+    if(is_rare)
     {
-        add_bet_record(_rareBets, _self, _stateConfig.rare_bets_id, player, bet, reward, roll_type, roll_border,
-                roll_value, _seed, inviter);
+        LOG_DEBUG("store reference to bets.rare\n");
+        add_bet_ref(_rareBets, _bets, _self, _stateConfig.rare_bets_id, _stateConfig.rare_bets_layout,
+                _stateConfig.bets_id, _stateConfig.bets_layout, bet_id, reward.amount, Bet::PIN_RARE);
     }
-    log("DEBUG: update record in 'players' table \n");
-    auto playerIt = update_player_statistics(_stateConfig, _players, player, bet, reward);
+    LOG_DEBUG("update player statistics\n");
+    update_player_statistics(player_row, bet, reward);
     _stateConfig.total_bet_amount += bet;
-    _leaderBoards.update_player_stats(*playerIt);
 }
 
 void Dice::setHighBetBound(eosio::name caller, eosio::asset high_bet_bound)
@@ -621,146 +1060,482 @@ void Dice::setRareBetBound(eosio::name caller, uint16_t rare_bet_bound)
     _stateConfig.rare_bet_bound = rare_bet_bound;
 }
 
-void Dice::send_to_jackpot_game(const eosio::name& player, const eosio::asset& quantity, uint64_t roll_value)
+void Dice::send_to_jackpot_game(tables::Player& player_row, const eosio::asset& quantity, uint64_t roll_value)
 {
-    log("send_to_jackpot_game(%, %)\n", player, roll_value);
-    require_auth(_self);
+    const auto& player = player_row.account;
+    LOG_DEBUG("send_to_jackpot_game(%, %)\n", player, roll_value);
 
     _stateConfig.jackpot_balance.amount += quantity.amount*_stateConfig.jackpot_percent;
-    log("DEBUG: Jackpot %\n", _stateConfig.jackpot_balance.amount);
+    LOG_DEBUG("Jackpot %\n", _stateConfig.jackpot_balance.amount);
 
-    auto it = _players.find(player.value);
+    bool is_jackpot = rules::jackpot_step(player_row.jackpot_sequence, player_row.jackpot_sequence_values,
+            roll_value);
+    LOG_DEBUG("jackpot player sequence %, roll %\n", player_row.jackpot_sequence, roll_value);
 
-    if (_players.end() == it) { return; }
+    if (is_jackpot) {
+        LOG_INFO("JACKPOT\n");
 
-    if ((*it).jackpot_sequence == 5) {
-        _players.modify(it, _stateConfig.owner, [&](auto& record)
+        _jackpots.emplace(_stateConfig.owner, [&](auto& record)
         {
-            record.jackpot_sequence = -1;
-            record.jackpot_sequence_values = "";
+            record.id = _jackpots.available_primary_key();
+            record.player = player;
+            record.time = eosio::time_point(eosio::seconds(now()));
+            record.amount = _stateConfig.jackpot_balance;
         });
-    }
 
-    uint8_t sequence = roll_value/10;
-    //uint8_t sequence = (*it).jackpot_sequence + 1;
-    int player_sequence = (*it).jackpot_sequence;
+        std::string msg = "Congradulations! You're JACKPOT winner! Receive your ";
+        msg.append(std::to_string(_stateConfig.jackpot_balance.amount));
+        msg.append(" EOS prize");
 
-    log("DEBUG: jackpot sequence %, roll %\n", sequence, roll_value);
-    log("DEBUG: jackpot player sequence %\n", player_sequence);
+        pay_for_win(player, _stateConfig.jackpot_balance, msg);
+        _stateConfig.jackpot_balance = eosio::asset(0, common::EOS_SYMBOL);
+        _stateConfig.jackpot_balance.amount = 0;
+    }
+}
 
-    if (player_sequence + 1 == sequence) {
-        _players.modify(it, _stateConfig.owner, [&](auto& record)
+void Dice::mint_tokens(const tables::Player& player_row, const eosio::asset& bet, const eosio::asset& reward,
+        const eosio::name& inviter)
+{
+    const auto& player = player_row.account;
+    LOG_DEBUG("mint_tokens(%, %, %, %)\n", player, bet, reward, inviter);
+    LOG_DEBUG("day.bets=%\n", player_row.day.bets);
+    auto multiplier = get_bonus_multiplier(get_bonus_tiers(), player_row.day);
+    int64_t ante_count = ((double)bet.amount / _stateConfig.ante_in_eos) * multiplier;
+    auto mint_amount = eosio::asset{ante_count, common::ANTE_SYMBOL};
+    LOG_DEBUG("mint_amount=% bonus_multiplier=% bet=%\n", mint_amount, multiplier, bet);
+    if(_stateConfig.enabled_minting && _stateConfig.ante_token != _self && mint_amount.amount > 0)
+    {
+        auto index = _pendingMints.get_index<"byrecipient"_n>();
+        auto it = index.find(PendingMint::recipient_key(player, inviter));
+        if(it != index.end())
         {
-            record.jackpot_sequence = sequence;
-            record.jackpot_sequence_values.append(std::to_string(roll_value));
-            record.jackpot_sequence_values.append(";");
-        });
-        if (sequence == 5) {
-            log("JACKPOT\n");
-
-            _jackpots.emplace(_stateConfig.owner, [&](auto& record)
+            index.modify(it, _self, [&](auto& record)
             {
-                record.id = _jackpots.available_primary_key();
-                record.player = player;
-                record.time = eosio::time_point(eosio::seconds(now()));
-                record.amount = _stateConfig.jackpot_balance;
+                record.quantity += mint_amount;
             });
-
-            std::string msg = "Congradulations! You're JACKPOT winner! Receive your ";
-            msg.append(std::to_string(_stateConfig.jackpot_balance.amount));
-            msg.append(" EOS prize");
-
-            pay_for_win(player, _stateConfig.jackpot_balance, msg);
-            _stateConfig.jackpot_balance = eosio::asset(0, common::EOS_SYMBOL);
-            _stateConfig.jackpot_balance.amount = 0;
+            return;
         }
-    } 
-    else 
-    {
-        _players.modify(it, _stateConfig.owner, [&](auto& record)
+        auto id = _pendingMints.available_primary_key();
+        _pendingMints.emplace(_self, [&](auto& record)
         {
-            record.jackpot_sequence = -1;
-            record.jackpot_sequence_values = "";
+            record.id = id;
+            record.player = player;
+            record.inviter = inviter;
+            record.quantity = mint_amount;
+            record.time = eosio::time_point_sec(now());
         });
     }
 }
 
-void Dice::mint_tokens(const eosio::name& player, const eosio::asset& bet, const eosio::asset& reward,
-        const eosio::name& inviter)
+/*
+ * mints up to count rows which reached flush amount or age by one deferred transaction,
+ * rows are ordered by id, so aged rows are at the beginning
+ * */
+void Dice::flush_mints(uint16_t count)
 {
-    log("mint_tokens(%, %, %, %)\n", player, bet, reward, inviter);
-    require_auth(_self);
-    auto it = _players.find(player.value);
-    eosio_assert(it != _players.end(), "Logic error.");
-    log("DEBUG: day.bets=%\n", it->day.bets);
-    auto multiplier = get_bonus_multiplier(_bonusesConfig, it->day);
-    int64_t ante_count = ((double)bet.amount / _stateConfig.ante_in_eos) * multiplier;
-    auto mint_amount = eosio::asset{ante_count, common::ANTE_SYMBOL};
-    log("DEBUG: mint_amount=% bonus_multiplier=% bet=%\n", mint_amount, multiplier, bet);
-    if(_stateConfig.enabled_minting && _stateConfig.ante_token != _self)
+    LOG_DEBUG("flush_mints(%)\n", count);
+    eosio::transaction deferred;
+    for(auto it = _pendingMints.begin(); it != _pendingMints.end() && count > 0;)
     {
-        eosio::transaction deferred;
+        if(it->time.utc_seconds + PendingMint::flush_age > now() && it->quantity.amount < PendingMint::flush_amount)
+        {
+            ++it;
+            continue;
+        }
         deferred.actions.emplace_back(
                 permission_level{_self, "active"_n},
                 _stateConfig.ante_token, "mint"_n,
                 std::make_tuple(
                         _stateConfig.admin,
-                        mint_amount,
-                        player,
-                        inviter.value
+                        it->quantity,
+                        it->player,
+                        it->inviter.value
                 )
         );
-        deferred.delay_sec = 1;
-        uint128_t deferred_id =  _stateConfig.next_deferred_id(TransactionNumber::MINT);
-        deferred.send(deferred_id, _self);
+        it = _pendingMints.erase(it);
+        --count;
+    }
+    if(deferred.actions.empty())
+    {
+        return;
+    }
+    deferred.delay_sec = 1;
+    uint128_t deferred_id =  _stateConfig.next_deferred_id(TransactionNumber::MINT);
+    deferred.send(deferred_id, _self);
+}
+
+void Dice::flushMints(eosio::name caller, uint16_t count)
+{
+    require_auth(caller);
+    eosio_assert(_self == caller || _stateConfig.admin == caller || _stateConfig.owner == caller,
+            "You cannot call this function.");
+    eosio_assert(count > 0 && count <= PendingMint::flush_size, "Wrong flush size.");
+    // called periodically, so rows which are not ready yet are not an error
+    flush_mints(count);
+}
+
+const tables::AnteBonusTiers& Dice::get_bonus_tiers()
+{
+    if(!_stateBonusTiers)
+    {
+        if(_bonusTiersConfig.exists())
+        {
+            _stateBonusTiers = _bonusTiersConfig.get();
+        }
+        else
+        {
+            _stateBonusTiers = build_bonus_tiers(_bonusesConfig);
+            _bonusTiersConfig.set(*_stateBonusTiers, _self);
+        }
     }
+    return *_stateBonusTiers;
 }
 
 void Dice::resolveBet(eosio::name player, eosio::name inviter, eosio::asset quantity, uint8_t roll_type,
-                   uint16_t roll_border)
+                   uint16_t roll_border, uint8_t rolls)
 {
-    log("resolveBet(%, %, %, %, %)\n", player, inviter, quantity, roll_type, roll_border);
+    LOG_DEBUG("resolveBet(%, %, %, %, %, %)\n", player, inviter, quantity, roll_type, roll_border, rolls);
     require_auth(_self);
     eosio_assert(quantity.amount > 0, "Wrong quantity.");
-    uint64_t roll_value = get_random(_stateLimits.max_value);
+    eosio_assert(rolls > 0 && rolls <= memo::max_bet_rolls, "Wrong rolls count.");
+    if(rolls == 1)
+    {
+        uint64_t roll_value = get_random(_stateLimits.max_value);
+        settle_bet(player, inviter, quantity, roll_type, roll_border, rolls, [&]() { return roll_value; });
+        return;
+    }
+    // all rolls are drawn from one stream, roll is recorded with stream seed and index of its word
+    auto sseed = _random.create_sys_seed(0);
+    _random.seed(sseed, get_transaction_hash());
+    auto stream = _random.get_stream();
+    settle_bet(player, inviter, quantity, roll_type, roll_border, rolls, [&]()
+    {
+        auto roll_value = stream.next(_stateLimits.max_value);
+        _seed = stream.get_seed();
+        _seedWord = uint16_t(stream.get_word() + 1);
+        return roll_value;
+    });
+}
 
-    bool is_win = (roll_type == RollType::LEFT && roll_value < roll_border) ||
-            (roll_type == RollType::RIGHT && roll_value > roll_border);
+void Dice::enqueue_bet(const eosio::name& player, const eosio::name& inviter, const eosio::asset& quantity,
+        uint8_t roll_type, uint16_t roll_border, uint8_t rolls, bool is_session,
+        const tables::ResolveConfig& resolve)
+{
+    LOG_DEBUG("enqueue_bet(%, %, %, %, %, %)\n", player, inviter, quantity, roll_type, roll_border, rolls);
+    eosio_assert(_stateConfig.enabled_betting, "Betting is disabled.");
+    eosio_assert(!is_empty(resolve.house_commitment), "House seed is not committed.");
+    auto user_seed = get_transaction_hash();
+    _pendingBets.emplace(_self, [&](auto& record)
+    {
+        record.id = _pendingBets.available_primary_key();
+        record.player = player;
+        record.inviter = inviter;
+        record.quantity = quantity;
+        record.roll_type = roll_type;
+        record.roll_border = roll_border;
+        record.user_seed = user_seed;
+        record.house_commitment = resolve.house_commitment;
+        record.time = eosio::time_point(eosio::seconds(now()));
+        record.rolls = rolls;
+        record.is_session = is_session;
+    });
+}
+
+/*
+ * resolves all rolls of one bet transfer:
+ * every roll has its own history record, payout and mint are aggregated,
+ * player row and leaderboards are updated once
+ * */
+template<class F>
+void Dice::settle_bet(const eosio::name& player, const eosio::name& inviter, const eosio::asset& quantity,
+        uint8_t roll_type, uint16_t roll_border, uint8_t rolls, F&& draw)
+{
+    // player row is loaded once, updated in memory and written back once
+    auto player_it = _players.find(player.value);
+    auto player_row = player_it == _players.end() ? create_player(player) : *player_it;
+
+    eosio::asset total_reward{0, common::EOS_SYMBOL};
+    uint8_t wins = 0;
+    for(uint8_t roll = 0; roll < rolls; ++roll)
+    {
+        auto reward = settle_roll(player_row, inviter, quantity, roll_type, roll_border, draw());
+        if(reward.amount > 0)
+        {
+            total_reward += reward;
+            ++wins;
+        }
+    }
+    if(wins > 0)
+    {
+        LOG_DEBUG("win detected. reward=%\n", total_reward);
+        std::string msg = "You win! ";
+        if(rolls > 1)
+        {
+            msg += std::to_string(wins) + " of " + std::to_string(rolls) + " rolls won. ";
+        }
+        msg += "Your bet seed was: ";
+        append_hex(msg, _seed);
+        pay_for_win(player, total_reward, msg);
+    }
+    mint_tokens(player_row, eosio::asset{quantity.amount * rolls, quantity.symbol}, total_reward, inviter);
+
+    if(player_it == _players.end())
+    {
+        LOG_DEBUG("before emplace player\n");
+        _players.emplace(_stateConfig.owner, [&](auto& record)
+        {
+            record = player_row;
+        });
+    }
+    else
+    {
+        LOG_DEBUG("before modify player\n");
+        _players.modify(player_it, _stateConfig.owner, [&](auto& record)
+        {
+            record = player_row;
+        });
+    }
+    _leaderBoards.update_player_stats(player_row);
+}
+
+eosio::asset Dice::settle_roll(tables::Player& player_row, const eosio::name& inviter, const eosio::asset& quantity,
+        uint8_t roll_type, uint16_t roll_border, uint64_t roll_value)
+{
+    bool is_win = rules::is_win(roll_type == RollType::LEFT, roll_border, roll_value);
     eosio::asset reward{0, common::EOS_SYMBOL};
     _stateEosToken.in += quantity.amount;
     ++_stateEosToken.bets;
     if (is_win)
     {
         reward = get_bet_reward(roll_type, roll_border, quantity);
-
-        log("win detected. reward=%\n", reward);
-        std::string msg = "You win! Your bet seed was: ";
-        msg.append((const char*)_seed.hash);
-        pay_for_win(player, reward, msg);
-
         _stateEosToken.out += reward.amount;
         _stateEosToken.wons += 1;
     }
-    register_bet(player, quantity, reward, roll_type, roll_border, roll_value, inviter);
-    _referrals.on_player_bet(player, inviter, quantity, reward);
-    send_to_jackpot_game(player, quantity, roll_value);
-    mint_tokens(player, quantity, reward, inviter);
+    register_bet(player_row, quantity, reward, roll_type, roll_border, roll_value, inviter);
+    _referrals.on_player_bet(player_row.account, inviter, quantity, reward);
+    send_to_jackpot_game(player_row, quantity, roll_value);
+    return reward;
+}
+
+/*
+ * anyone can reveal: house seed is authenticated by hash chain,
+ * so player does not depend on house to resolve winning bet
+ * */
+void Dice::revealBet(uint64_t id, capi_checksum256 house_seed)
+{
+    LOG_DEBUG("revealBet(%)\n", id);
+    auto it = _pendingBets.find(id);
+    eosio_assert(it != _pendingBets.end(), "Pending bet not found.");
+    auto commitment = reveal_house_seed(house_seed);
+    eosio_assert(is_equal(commitment, it->house_commitment), "House seed does not match commitment.");
+
+    auto bet = *it;
+    _pendingBets.erase(it);
+    resolve_pending(bet, house_seed);
+}
+
+/*
+ * checks house seed against hash chain and moves chain forward when seed opens the current commitment,
+ * returns commitment of bets resolved by seed: sha256(sha256(seed))
+ * */
+capi_checksum256 Dice::reveal_house_seed(const capi_checksum256& house_seed)
+{
+    capi_checksum256 hash;
+    sha256(reinterpret_cast<const char*>(&house_seed), sizeof(house_seed), &hash);
+    auto resolve = _resolveConfig.get();
+    if(is_equal(resolve.house_commitment, hash))
+    {
+        // previous seed must be public for a whole block, bets of that block are resolved by this seed
+        eosio_assert(current_time() > resolve.revealed_time, "House seeds must be revealed in different blocks.");
+        // next house seed must hash to the revealed one
+        resolve.house_commitment = house_seed;
+        resolve.revealed_time = current_time();
+        _resolveConfig.set(resolve, _self);
+    }
+    capi_checksum256 commitment;
+    sha256(reinterpret_cast<const char*>(&hash), sizeof(hash), &commitment);
+    // seed ahead of chain would resolve bets of the block in which previous seed is revealed
+    eosio_assert(!is_equal(resolve.house_commitment, commitment), "Previous house seed is not revealed.");
+    return commitment;
 }
 
-uint64_t Dice::get_random(uint64_t max)
+/*
+ * random numbers of pending bet depend only on house seed and user seed of the bet
+ * */
+void Dice::resolve_pending(const tables::PendingBet& bet, const capi_checksum256& house_seed)
+{
+    _random.seed(house_seed, bet.user_seed);
+    if(bet.rolls == 1)
+    {
+        uint64_t roll_value = _random.generator(_stateLimits.max_value);
+        _seed = _random.get_seed();
+        _seedWord = 0;
+        settle_bet(bet.player, bet.inviter, bet.quantity, bet.roll_type, bet.roll_border, bet.rolls,
+                [&]() { return roll_value; });
+        return;
+    }
+    auto stream = _random.get_stream();
+    settle_bet(bet.player, bet.inviter, bet.quantity, bet.roll_type, bet.roll_border, bet.rolls, [&]()
+    {
+        auto roll_value = stream.next(_stateLimits.max_value);
+        _seed = stream.get_seed();
+        _seedWord = uint16_t(stream.get_word() + 1);
+        return roll_value;
+    });
+}
+
+void Dice::refundBet(uint64_t id)
+{
+    LOG_DEBUG("refundBet(%)\n", id);
+    auto it = _pendingBets.find(id);
+    eosio_assert(it != _pendingBets.end(), "Pending bet not found.");
+    require_auth(it->player);
+    auto resolve = _resolveConfig.get_or_default(default_resolve_config());
+    // once seed is revealed outcome of bet is known and it can be revealed by anyone, including player,
+    // seed of bet is unrevealed while chain is at commitment of bet or one seed after it
+    capi_checksum256 previous;
+    sha256(reinterpret_cast<const char*>(&resolve.house_commitment), sizeof(resolve.house_commitment), &previous);
+    eosio_assert(is_equal(resolve.house_commitment, it->house_commitment) || is_equal(previous, it->house_commitment),
+            "House seed is already revealed.");
+    auto timeout = std::max(resolve.reveal_timeout, tables::ResolveConfig::min_reveal_timeout);
+    eosio_assert(now() > it->time.sec_since_epoch() + timeout, "Reveal timeout is not expired.");
+
+    auto quantity = eosio::asset{it->quantity.amount * it->rolls, it->quantity.symbol};
+    if(it->is_session)
+    {
+        // session bet goes back to balance it was paid from, row removed by withdraw is paid by player
+        auto balance_it = _balances.find(it->player.value);
+        if(balance_it == _balances.end())
+        {
+            _balances.emplace(it->player, [&](auto& record)
+            {
+                record.player = it->player;
+                record.balance = quantity;
+            });
+        }
+        else
+        {
+            _balances.modify(balance_it, eosio::same_payer, [&](auto& record)
+            {
+                record.balance += quantity;
+            });
+        }
+    }
+    else
+    {
+        std::string msg = "Refund of unrevealed bet";
+        action(
+                permission_level{_self, "active"_n},
+                "eosio.token"_n,
+                "transfer"_n,
+                std::make_tuple(
+                        _stateConfig.owner,
+                        it->player,
+                        quantity,
+                        msg
+                )
+        ).send();
+    }
+    _stateConfig.eos_balance -= quantity;
+    _pendingBets.erase(it);
+}
+
+/*
+ * reveals house seed and resolves up to count oldest pending bets of it, anyone can call it like reveal,
+ * every bet is resolved as by reveal, so its result does not depend on which bets share the batch,
+ * seed without bets only moves hash chain forward
+ * */
+void Dice::resolveBatch(uint16_t count, capi_checksum256 house_seed)
+{
+    LOG_DEBUG("resolveBatch(%)\n", count);
+    eosio_assert(count > 0, "Batch size must be greater than 0.");
+    auto commitment = reveal_house_seed(house_seed);
+
+    // bets committed to one seed are consecutive, hash chain only moves forward
+    auto it = _pendingBets.begin();
+    for(; it != _pendingBets.end() && count > 0 && is_equal(it->house_commitment, commitment); --count)
+    {
+        auto bet = *it;
+        it = _pendingBets.erase(it);
+        resolve_pending(bet, house_seed);
+    }
+}
+
+void Dice::makeSessionBet(eosio::name player, eosio::asset quantity, uint8_t roll_type, uint16_t roll_border,
+        eosio::name inviter, uint8_t rolls)
+{
+    LOG_DEBUG("makeSessionBet(%, %, %, %, %, %)\n", player, quantity, roll_type, roll_border, inviter, rolls);
+    require_auth(player);
+    eosio_assert(player != _self && player != _stateConfig.owner && player != _stateConfig.admin,
+            "You cannot call this function.");
+    eosio_assert(quantity.is_valid() && quantity.symbol == common::EOS_SYMBOL && quantity.amount > 0,
+            "Wrong quantity.");
+    eosio_assert(rolls > 0 && rolls <= memo::max_bet_rolls, "Wrong rolls count.");
+    auto it = _balances.find(player.value);
+    eosio_assert(it != _balances.end() && it->balance >= quantity, "Not enough balance.");
+    _balances.modify(it, eosio::same_payer, [&](auto& record)
+    {
+        record.balance -= quantity;
+    });
+    place_bet(player, quantity, memo::BetMemo{roll_type, roll_border, inviter, rolls}, true);
+}
+
+void Dice::withdraw(eosio::name player, eosio::asset quantity)
+{
+    LOG_DEBUG("withdraw(%, %)\n", player, quantity);
+    require_auth(player);
+    // balance holds winnings too, they leave contract only when payouts are enabled
+    eosio_assert(_stateConfig.enabled_payout, "Payouts are disabled.");
+    eosio_assert(quantity.is_valid() && quantity.symbol == common::EOS_SYMBOL && quantity.amount > 0,
+            "Wrong quantity.");
+    auto it = _balances.find(player.value);
+    eosio_assert(it != _balances.end() && it->balance >= quantity, "Not enough balance.");
+    if(it->balance == quantity)
+    {
+        // empty balance is removed, next winnings are transferred directly
+        _balances.erase(it);
+    }
+    else
+    {
+        _balances.modify(it, eosio::same_payer, [&](auto& record)
+        {
+            record.balance -= quantity;
+        });
+    }
+    std::string msg = "Withdraw from balance";
+    action(
+            permission_level{_self, "active"_n},
+            "eosio.token"_n,
+            "transfer"_n,
+            std::make_tuple(
+                    _stateConfig.owner,
+                    player,
+                    quantity,
+                    msg
+            )
+    ).send();
+}
+
+capi_checksum256 Dice::get_transaction_hash()
 {
-    auto sseed = _random.create_sys_seed(0);
     auto size = transaction_size();
     char buffer[size];
     read_transaction(&buffer[0], size);
     capi_checksum256 checksum;
     sha256(buffer, size, &checksum);
-    printhex(&checksum, sizeof(checksum));
-    print("\n");
+    return checksum;
+}
+
+uint64_t Dice::get_random(uint64_t max)
+{
+    auto sseed = _random.create_sys_seed(0);
+    auto checksum = get_transaction_hash();
+    LOG_DEBUG_HEX(&checksum, sizeof(checksum));
     _random.seed(sseed, checksum);
     uint64_t result = _random.generator(max);
-    log("get_random(%)->%\n", max, result);
+    LOG_DEBUG("get_random(%)->%\n", max, result);
     _seed = _random.get_seed();
+    _seedWord = 0;
     return result;
 }
 
@@ -801,5 +1576,138 @@ void Dice::setRefferalMultiplier(eosio::name caller, double multiplier)
     _stateConfig.referral_multiplier = multiplier;
 }
 
+void Dice::migrateConfig(eosio::name caller)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(_isLegacyConfig, "Config is already migrated.");
+    // ids of legacy history rows must not move until bets.migrate has finished every table
+    eosio_assert(!_stateConfig.enabled_betting, "Betting must be disabled during migration.");
+    // legacy history rows are keyed by ids up to last, rings start after them and are filled by bets.migrate
+    _stateConfig.bets_layout = RingLayout::start(_stateConfig.bets_id.last + 1, true);
+    _stateConfig.high_bets_layout = RingLayout::start(_stateConfig.high_bets_id.last + 1, true);
+    _stateConfig.rare_bets_layout = RingLayout::start(_stateConfig.rare_bets_id.last + 1, true);
+    // destructor writes cfg.state and cfg.settings
+    _globalConfig.remove();
+    _isLegacyConfig = false;
+    _isNewState = true;
+}
+
+void Dice::migrateBets(eosio::name caller, eosio::name table, uint64_t from_id, uint16_t count)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(!_stateConfig.enabled_betting, "Betting must be disabled during migration.");
+    eosio_assert(!_isLegacyConfig, "Config must be migrated by cfg.migrate.");
+    auto& layout = table == "bets.all"_n ? _stateConfig.bets_layout
+            : table == "bets.high"_n ? _stateConfig.high_bets_layout : _stateConfig.rare_bets_layout;
+    eosio_assert(table == "bets.all"_n || table == "bets.high"_n || table == "bets.rare"_n, "Unknown history table.");
+    // ids after legacy rows belong to ring rows once bets are accepted again
+    eosio_assert(layout.legacy, "History table is already migrated.");
+    uint64_t next_id = 0;
+    if(table == "bets.all"_n)
+    {
+        tables::LegacyBets legacy(_self, _self.value);
+        next_id = migrate_bet_records(legacy, _bets, _self, _stateConfig.bets_id, layout, from_id, count);
+    }
+    else if(table == "bets.high"_n)
+    {
+        tables::LegacyHighBets legacy(_self, _self.value);
+        next_id = migrate_bet_refs(legacy, _highBets, _bets, _self, _stateConfig.high_bets_id, layout, from_id,
+                count, Bet::PIN_HIGH);
+    }
+    else
+    {
+        tables::LegacyRareBets legacy(_self, _self.value);
+        next_id = migrate_bet_refs(legacy, _rareBets, _bets, _self, _stateConfig.rare_bets_id, layout, from_id,
+                count, Bet::PIN_RARE);
+    }
+    layout.legacy = next_id != std::numeric_limits<uint64_t>::max();
+    log("migrateBets: next id %\n", next_id);
+}
+
+void Dice::reindexPlayers(eosio::name caller, eosio::name from, uint16_t count)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(!_stateConfig.enabled_betting, "Betting must be disabled during migration.");
+    // remove row with all index entries ever used and store it again with current indexes
+    tables::LegacyPlayers legacy(_self, _self.value);
+    auto it = legacy.lower_bound(from.value);
+    for(; it != legacy.end() && count > 0; --count)
+    {
+        auto player = *it;
+        it = legacy.erase(it);
+        _players.emplace(_stateConfig.owner, [&](auto& record)
+        {
+            record = player;
+        });
+    }
+    log("reindexPlayers: next account %\n", it == legacy.end() ? eosio::name() : it->account);
+}
+
+void Dice::setAnteBonus(eosio::name caller, uint16_t begin, uint16_t end, double multiplier)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(multiplier > 0, "multiplier > 0 expected");
+    validate_bonus_tier(_bonusesConfig, begin, end);
+    auto it = _bonusesConfig.find(begin);
+    if(it == _bonusesConfig.end())
+    {
+        _bonusesConfig.emplace(_self, [&](auto& record)
+        {
+            record.begin = begin;
+            record.end = end;
+            record.multiplier = multiplier;
+        });
+    }
+    else
+    {
+        _bonusesConfig.modify(it, _self, [&](auto& record)
+        {
+            record.end = end;
+            record.multiplier = multiplier;
+        });
+    }
+    _bonusTiersConfig.set(build_bonus_tiers(_bonusesConfig), _self);
+}
+
+void Dice::removeAnteBonus(eosio::name caller, uint16_t begin)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    auto it = _bonusesConfig.find(begin);
+    eosio_assert(it != _bonusesConfig.end(), "Bonus tier not found.");
+    _bonusesConfig.erase(it);
+    _bonusTiersConfig.set(build_bonus_tiers(_bonusesConfig), _self);
+}
+
+void Dice::setResolveMode(eosio::name caller, uint8_t mode, uint32_t reveal_timeout)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(mode == ResolveMode::DEFERRED || mode == ResolveMode::REVEAL || mode == ResolveMode::BATCH,
+            "Unsupported resolve mode.");
+    eosio_assert(mode != ResolveMode::REVEAL || reveal_timeout >= tables::ResolveConfig::min_reveal_timeout,
+            "Reveal timeout is too short.");
+    auto resolve = _resolveConfig.get_or_default(default_resolve_config());
+    resolve.mode = mode;
+    resolve.reveal_timeout = std::max(reveal_timeout, tables::ResolveConfig::min_reveal_timeout);
+    _resolveConfig.set(resolve, _self);
+}
+
+void Dice::setHouseCommitment(eosio::name caller, capi_checksum256 commitment)
+{
+    require_auth(caller);
+    eosio_assert(_stateConfig.admin == caller || _stateConfig.owner == caller, "You cannot call this function.");
+    eosio_assert(!is_empty(commitment), "Wrong commitment value.");
+    // pending bets stay refundable only while their commitment is the current one
+    eosio_assert(_pendingBets.begin() == _pendingBets.end(), "Pending bets must be revealed or refunded first.");
+    auto resolve = _resolveConfig.get_or_default(default_resolve_config());
+    resolve.house_commitment = commitment;
+    _resolveConfig.set(resolve, _self);
+}
+
 }//dice
 
@@ -7,6 +7,8 @@
 #endif
 
 #include <dice/logger.hpp>
+#include <dice/log_levels.hpp>
+#include <dice/memo.hpp>
 #include <dice/tables.hpp>
 #include <dice/leaderboards.hpp>
 
@@ -23,35 +25,81 @@ protected:
     tables::Config _stateConfig;
     tables::BetToken _stateEosToken;
     tables::DiceLimit _stateLimits;
+    // states as they were loaded from singletons, used to skip unchanged writes
+    tables::Config _loadedConfig;
+    tables::BetToken _loadedEosToken;
+    tables::DiceLimit _loadedLimits;
+    bool _isNewState = false;
+    bool _isLegacyConfig = false;       // config is stored in cfg.main until cfg.migrate
     // singletons
     tables::ContractConfig _globalConfig;
+    tables::ContractState _contractState;
+    tables::ContractSettings _contractSettings;
     tables::DiceLimits _diceLimits;
     tables::BetTokens _betTokens;
     // tables
     tables::AnteBonusesConfig _bonusesConfig;
+    tables::AnteBonusTiersConfig _bonusTiersConfig;
+    std::optional<tables::AnteBonusTiers> _stateBonusTiers; // loaded on first mint
+    tables::PayoutTables _payoutTableConfig;
+    std::optional<tables::PayoutTable> _statePayoutTable; // loaded on first reward calculation
     tables::Bets _bets;
     tables::HighBets _highBets;
     tables::RareBets _rareBets;
     tables::Players _players;
     tables::Jackpots _jackpots;
+    tables::ResolveConfigs _resolveConfig;
+    tables::PendingBets _pendingBets;
+    tables::Balances _balances;
+    tables::PendingMints _pendingMints;
 
     common::random _random;
     capi_checksum256 _seed;
+    uint16_t _seedWord = 0;             // 0: roll is taken from _seed, n: from word n - 1 of stream of _seed
+
+    // winnings aggregated per player within action, paid once in destructor
+    struct Payout
+    {
+        eosio::name player;
+        eosio::asset quantity;
+        std::string message;
+        uint16_t count;
+    };
+    std::vector<Payout> _payouts;
 
     common::Referrals _referrals;
     LeaderBoards _leaderBoards;
 
     void on_replenishment(const common::tables::TokenTransfer& transfer);
     void on_bet(const common::tables::TokenTransfer& transfer);
+    void on_deposit(const common::tables::TokenTransfer& transfer);
+    void place_bet(const eosio::name& player, const eosio::asset& total, const memo::BetMemo& bet_memo,
+            bool is_session);
     eosio::asset get_bet_reward(uint8_t roll_type, uint16_t roll_border, const eosio::asset& quantity);
+    const tables::PayoutTable& get_payout_table();
+    void update_payout_table();
     uint64_t get_random(uint64_t max);
+    capi_checksum256 get_transaction_hash();
+    void enqueue_bet(const eosio::name& player, const eosio::name& inviter, const eosio::asset& quantity,
+            uint8_t roll_type, uint16_t roll_border, uint8_t rolls, bool is_session,
+            const tables::ResolveConfig& resolve);
+    capi_checksum256 reveal_house_seed(const capi_checksum256& house_seed);
+    void resolve_pending(const tables::PendingBet& bet, const capi_checksum256& house_seed);
+    template<class F>
+    void settle_bet(const eosio::name& player, const eosio::name& inviter, const eosio::asset& quantity,
+            uint8_t roll_type, uint16_t roll_border, uint8_t rolls, F&& draw);
+    eosio::asset settle_roll(tables::Player& player_row, const eosio::name& inviter, const eosio::asset& quantity,
+            uint8_t roll_type, uint16_t roll_border, uint64_t roll_value);
     uint8_t get_winners(uint8_t roll_type, uint16_t roll_border);
     void pay_for_win(const eosio::name& player, const eosio::asset& quantity, std::string& message);
-    void register_bet(const eosio::name& player, const eosio::asset& bet, const eosio::asset& reward,
+    void flush_payouts();
+    void register_bet(tables::Player& player_row, const eosio::asset& bet, const eosio::asset& reward,
                             uint8_t roll_type, uint16_t roll_border, uint16_t roll_value, const eosio::name& inviter);
-    void send_to_jackpot_game(const eosio::name& player, const eosio::asset& quantity, uint64_t roll_value);
-    void mint_tokens(const eosio::name& player, const eosio::asset& bet, const eosio::asset& reward,
+    void send_to_jackpot_game(tables::Player& player_row, const eosio::asset& quantity, uint64_t roll_value);
+    const tables::AnteBonusTiers& get_bonus_tiers();
+    void mint_tokens(const tables::Player& player_row, const eosio::asset& bet, const eosio::asset& reward,
             const eosio::name& inviter);
+    void flush_mints(uint16_t count);
 public:
     Dice(eosio::name receiver, eosio::name code, eosio::datastream<const char*> ds);
     ~Dice();
@@ -77,16 +125,33 @@ public:
     [[eosio::action("mlp.set")]] void setMonthLeaderPercent(eosio::name caller, double percent);
     [[eosio::action("jackpot.set")]] void setJackpotPercent(eosio::name caller, double percent);
     [[eosio::action("referral.set")]] void setRefferalMultiplier(eosio::name caller, double multiplier);
+    [[eosio::action("resolve.set")]] void setResolveMode(eosio::name caller, uint8_t mode, uint32_t reveal_timeout);
+    [[eosio::action("commit.set")]] void setHouseCommitment(eosio::name caller, capi_checksum256 commitment);
+    [[eosio::action("bets.migrate")]] void migrateBets(eosio::name caller, eosio::name table, uint64_t from_id,
+            uint16_t count);
+    [[eosio::action("plrs.reindex")]] void reindexPlayers(eosio::name caller, eosio::name from, uint16_t count);
+    [[eosio::action("bonus.set")]] void setAnteBonus(eosio::name caller, uint16_t begin, uint16_t end, double multiplier);
+    [[eosio::action("bonus.del")]] void removeAnteBonus(eosio::name caller, uint16_t begin);
+    [[eosio::action("cfg.migrate")]] void migrateConfig(eosio::name caller);
     [[eosio::action("notify")]] void notify(std::string);
 
     [[eosio::action("distribute")]] void distributeLeadersBonuses(eosio::name caller, uint8_t type,
             const std::vector<eosio::name>& leaders, eosio::asset bonus);
 
     [[eosio::action("bet")]] void makeBet(eosio::name player, eosio::name inviter, eosio::asset quantity,
-                                          uint8_t roll_type, uint16_t roll_border);
+                                          uint8_t roll_type, uint16_t roll_border, uint8_t rolls);
 
     [[eosio::action("resolved")]] void resolveBet(eosio::name player, eosio::name inviter, eosio::asset quantity,
-                                                  uint8_t roll_type, uint16_t roll_border);
+                                                  uint8_t roll_type, uint16_t roll_border, uint8_t rolls);
+
+    [[eosio::action("reveal")]] void revealBet(uint64_t id, capi_checksum256 house_seed);
+    [[eosio::action("refund")]] void refundBet(uint64_t id);
+    [[eosio::action("resolve.batch")]] void resolveBatch(uint16_t count, capi_checksum256 house_seed);
+
+    [[eosio::action("bet.session")]] void makeSessionBet(eosio::name player, eosio::asset quantity, uint8_t roll_type,
+            uint16_t roll_border, eosio::name inviter, uint8_t rolls);
+    [[eosio::action("withdraw")]] void withdraw(eosio::name player, eosio::asset quantity);
+    [[eosio::action("mint.flush")]] void flushMints(eosio::name caller, uint16_t count);
 
     //catched events
     void on_transfer();
@@ -126,6 +191,19 @@ void apply(uint64_t receiver, uint64_t code, uint64_t action)
     DISPATCH_ME(dice::Dice::setMonthLeaderPercent, mlp.set)
     DISPATCH_ME(dice::Dice::setJackpotPercent, jackpot.set)
     DISPATCH_ME(dice::Dice::setRefferalMultiplier, referral.set)
+    DISPATCH_ME(dice::Dice::setResolveMode, resolve.set)
+    DISPATCH_ME(dice::Dice::setHouseCommitment, commit.set)
+    DISPATCH_ME(dice::Dice::revealBet, reveal)
+    DISPATCH_ME(dice::Dice::refundBet, refund)
+    DISPATCH_ME(dice::Dice::resolveBatch, resolve.batch)
+    DISPATCH_ME(dice::Dice::makeSessionBet, bet.session)
+    DISPATCH_ME(dice::Dice::withdraw, withdraw)
+    DISPATCH_ME(dice::Dice::flushMints, mint.flush)
+    DISPATCH_ME(dice::Dice::migrateBets, bets.migrate)
+    DISPATCH_ME(dice::Dice::reindexPlayers, plrs.reindex)
+    DISPATCH_ME(dice::Dice::setAnteBonus, bonus.set)
+    DISPATCH_ME(dice::Dice::removeAnteBonus, bonus.del)
+    DISPATCH_ME(dice::Dice::migrateConfig, cfg.migrate)
 
     DISPATCH_EXTERNAL(eosio, onerror, dice::Dice::on_error)
     DISPATCH_EXTERNAL(eosio.token, transfer, dice::Dice::on_transfer)
@@ -0,0 +1,41 @@
+#pragma once
+#include <dice/logger.hpp>
+
+/*
+ * Leveled logging on top of log() from logger.hpp.
+ * Disabled levels expand to nothing, so their arguments are not evaluated at all.
+ * DEBUG_CONTRACT builds log everything, release builds log errors only,
+ * define LOG_LEVEL to override. Messages which must reach release builds use log() directly.
+ * */
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef LOG_LEVEL
+    #ifdef DEBUG_CONTRACT
+        #define LOG_LEVEL LOG_LEVEL_DEBUG
+    #else
+        #define LOG_LEVEL LOG_LEVEL_ERROR
+    #endif
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+    #define LOG_ERROR(...) log(__VA_ARGS__)
+#else
+    #define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    #define LOG_INFO(...) log(__VA_ARGS__)
+#else
+    #define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    #define LOG_DEBUG(...) log(__VA_ARGS__)
+    #define LOG_DEBUG_HEX(data, size) do { printhex((data), (size)); prints("\n"); } while(0)
+#else
+    #define LOG_DEBUG(...) ((void)0)
+    #define LOG_DEBUG_HEX(data, size) ((void)0)
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/name.hpp>
+#include <string_view>
+#include <limits>
+
+namespace dice {
+namespace memo {
+
+/*
+ * splits string by delimiter without allocations,
+ * tokens are views into the source string
+ * */
+class Tokenizer
+{
+public:
+    explicit Tokenizer(std::string_view str, char delimiter = ',')
+        : _rest(str), _delimiter(delimiter), _finished(false)
+    {
+    }
+
+    // returns false when there are no more tokens
+    bool next(std::string_view& token)
+    {
+        if(_finished)
+        {
+            return false;
+        }
+        auto pos = _rest.find(_delimiter);
+        if(pos == std::string_view::npos)
+        {
+            token = _rest;
+            _finished = true;
+        }
+        else
+        {
+            token = _rest.substr(0, pos);
+            _rest.remove_prefix(pos + 1);
+        }
+        return true;
+    }
+
+private:
+    std::string_view _rest;
+    char _delimiter;
+    bool _finished;
+};
+
+/*
+ * strict decimal parser: digits only, no sign, no spaces, value <= max
+ * */
+inline bool parse_uint(std::string_view str, uint64_t max, uint64_t& value)
+{
+    if(str.empty())
+    {
+        return false;
+    }
+    uint64_t result = 0;
+    for(char c: str)
+    {
+        if(c < '0' || c > '9')
+        {
+            return false;
+        }
+        uint64_t digit = c - '0';
+        if(result > (max - digit) / 10)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+// max number of rolls in one bet transfer
+constexpr uint8_t max_bet_rolls = 20;
+
+/*
+ * decoded bet memo
+ *     bet,roll_type,roll_border,inviter      - bet with inviter
+ *     bet,roll_type,roll_border              - bet without inviter
+ *     bet,roll_type,roll_border,inviter,xN   - N rolls, inviter may be empty
+ * */
+struct BetMemo
+{
+    uint8_t roll_type;                  // 1 || 2
+    uint16_t roll_border;               // roll border ie: 50
+    eosio::name inviter;                // empty if memo has no inviter
+    uint8_t rolls;                      // number of rolls, transferred amount is split equally between them
+};
+
+inline BetMemo parse_bet(std::string_view str)
+{
+    BetMemo result{0, 0, eosio::name(), 1};
+    Tokenizer tokenizer(str);
+    std::string_view token;
+
+    eosio_assert(tokenizer.next(token) && token == "bet", "Wrong memo parameter.");
+
+    eosio_assert(tokenizer.next(token), "Wrong memo parameter.");
+    eosio_assert(!token.empty(), "Roll type cannot be empty!");
+    uint64_t value = 0;
+    eosio_assert(parse_uint(token, std::numeric_limits<uint8_t>::max(), value), "Wrong roll type.");
+    result.roll_type = value;
+
+    eosio_assert(tokenizer.next(token), "Wrong memo parameter.");
+    eosio_assert(!token.empty(), "Roll prediction cannot be empty!");
+    eosio_assert(parse_uint(token, std::numeric_limits<uint16_t>::max(), value), "Wrong roll prediction.");
+    result.roll_border = value;
+
+    if(tokenizer.next(token) && !token.empty())
+    {
+        result.inviter = eosio::name(token);
+    }
+    if(tokenizer.next(token))
+    {
+        eosio_assert(token.size() > 1 && token[0] == 'x', "Wrong rolls count.");
+        token.remove_prefix(1);
+        eosio_assert(parse_uint(token, max_bet_rolls, value) && value > 0, "Wrong rolls count.");
+        result.rolls = value;
+    }
+    eosio_assert(!tokenizer.next(token), "Wrong memo parameter.");
+    return result;
+}
+
+}//namespace memo
+}//namespace dice
@@ -1,6 +1,8 @@
 #pragma once
 #include <eosiolib/transaction.hpp>
 #include <eosiolib/crypto.h>
+#include <cstring>
+#include <limits>
 
 namespace common
 {
@@ -31,6 +33,35 @@ public:
         ChecksumType seed2;
     };
 
+    /*
+     * stream of unbiased random numbers from one seed,
+     * block k of stream is sha256 of 40 bytes: seed followed by k as 64 bit little endian,
+     * word n of stream is 64 bit word n % 4 of block n / 4
+     * */
+    class stream
+    {
+    public:
+        static constexpr uint8_t words = sizeof(ChecksumType) / sizeof(uint64_t);
+
+        explicit stream(const ChecksumType& seed);
+
+        // next number ranged [0, max-1], rejection sampling removes modulo bias
+        uint64_t next(uint64_t max = 101);
+        uint64_t next64();
+
+        const ChecksumType& get_seed() const;
+
+        // index of word which produced the last number
+        uint64_t get_word() const;
+    private:
+        void refill();
+
+        ChecksumType _seed;
+        uint64_t _counter;
+        ChecksumType _block;
+        uint8_t _word;
+    };
+
 public:
     random();
     ~random();
@@ -47,6 +78,9 @@ public:
 
     uint64_t gen(ChecksumType& seed, uint64_t max = 101) const;
 
+    // stream seeded with current state of generator
+    stream get_stream() const;
+
     ChecksumType get_sys_seed() const;
     ChecksumType get_user_seed() const;
     ChecksumType get_mixed() const;
@@ -105,6 +139,69 @@ uint64_t random::gen(ChecksumType& seed, uint64_t max) const
     return r;
 }
 
+random::stream random::get_stream() const
+{
+    return stream(_seed);
+}
+
+random::stream::stream(const ChecksumType& seed)
+{
+    _seed = seed;
+    _counter = 0;
+    _word = words;
+}
+
+void random::stream::refill()
+{
+    // explicit buffer, struct of seed and counter would be padded to alignment of ChecksumType
+    char buffer[sizeof(ChecksumType) + sizeof(uint64_t)];
+    std::memcpy(buffer, _seed.hash, sizeof(ChecksumType));
+    for (uint8_t i = 0; i < sizeof(uint64_t); ++i)
+    {
+        buffer[sizeof(ChecksumType) + i] = char(_counter >> (8 * i));
+    }
+    ::sha256(buffer, sizeof(buffer), &_block);
+    ++_counter;
+    _word = 0;
+}
+
+uint64_t random::stream::next64()
+{
+    if (_word == words)
+    {
+        refill();
+    }
+    const uint64_t *p64 = reinterpret_cast<const uint64_t *>(&_block);
+    return p64[_word++];
+}
+
+uint64_t random::stream::next(uint64_t max)
+{
+    if (max <= 1)
+    {
+        return 0;
+    }
+    // 2^64 mod max, values above the last complete range of max numbers are rejected
+    const uint64_t rest = (std::numeric_limits<uint64_t>::max() % max + 1) % max;
+    const uint64_t limit = std::numeric_limits<uint64_t>::max() - rest;
+    uint64_t r = next64();
+    while (r > limit)
+    {
+        r = next64();
+    }
+    return r % max;
+}
+
+const ChecksumType& random::stream::get_seed() const
+{
+    return _seed;
+}
+
+uint64_t random::stream::get_word() const
+{
+    return (_counter - 1) * words + _word - 1;
+}
+
 ChecksumType random::get_sys_seed() const
 {
     return _sseed;
@@ -0,0 +1,100 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace dice {
+namespace rules {
+
+/*
+ * game rules without chain intrinsics and eosiolib types,
+ * the contract and host builds share them to get identical results
+ * */
+
+// fixed point precision of payout multipliers
+constexpr uint8_t payout_precision_bits = 48;
+
+// roll values of full jackpot sequence are 0x, 1x, ..., 5x
+constexpr int jackpot_sequence_end = 5;
+
+// amount of winning roll values
+inline uint8_t winners(bool is_left, uint16_t roll_border, uint16_t max_bet_num)
+{
+    return is_left ? roll_border : max_bet_num - 1 - roll_border;
+}
+
+inline bool is_win(bool is_left, uint16_t roll_border, uint64_t roll_value)
+{
+    return is_left ? roll_value < roll_border : roll_value > roll_border;
+}
+
+/*
+ * payout multiplier for every amount of winners,
+ * winners fit uint8_t, so table never needs more than 256 entries
+ * multipliers are rounded to nearest, for amounts up to total EOS supply reward(amount, multiplier) differs from
+ * int64_t(amount * (1 - platform_fee) * (100.0 / num)) by at most one unit (checked by tools/payout_check.cpp)
+ * */
+inline std::vector<uint64_t> payout_multipliers(double platform_fee, uint16_t max_bet_num, uint16_t max_value)
+{
+    size_t size = std::max<size_t>(max_bet_num, max_value + 1);
+    size = std::min<size_t>(size, std::numeric_limits<uint8_t>::max() + 1);
+    std::vector<uint64_t> result(size, 0);
+    for(size_t num = 1; num < size; ++num)
+    {
+        result[num] = uint64_t((1 - platform_fee) * (100.0 / num) * (1ull << payout_precision_bits) + 0.5);
+    }
+    return result;
+}
+
+inline int64_t reward(int64_t amount, uint64_t multiplier)
+{
+    return int64_t((static_cast<unsigned __int128>(amount) * multiplier) >> payout_precision_bits);
+}
+
+/*
+ * moves player jackpot sequence by one roll,
+ * returns true when sequence is completed and jackpot is won
+ * */
+inline bool jackpot_step(int& sequence, std::string& values, uint64_t roll_value)
+{
+    if(sequence == jackpot_sequence_end)
+    {
+        sequence = -1;
+        values = "";
+    }
+    int next = uint8_t(roll_value / 10);
+    if(sequence + 1 != next)
+    {
+        sequence = -1;
+        values = "";
+        return false;
+    }
+    sequence = next;
+    values.append(std::to_string(roll_value));
+    values.append(";");
+    return sequence == jackpot_sequence_end;
+}
+
+/*
+ * ante bonus multiplier for amount of player bets,
+ * tiers are sorted by begin and do not overlap
+ * */
+template<class It>
+double bonus_multiplier(It begin, It end, uint64_t bets_count)
+{
+    // last tier which begins before bets_count
+    auto it = std::upper_bound(begin, end, bets_count, [](uint64_t count, const auto& tier)
+    {
+        return count < tier.begin;
+    });
+    if(it != begin && bets_count <= (--it)->end)
+    {
+        return it->multiplier;
+    }
+    return 1.0;
+}
+
+}//namespace rules
+}//namespace dice
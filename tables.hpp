@@ -4,20 +4,27 @@
 #include <eosiolib/multi_index.hpp>
 #include <eosiolib/singleton.hpp>
 #include <eosiolib/time.hpp>
+#include <dice/rules.hpp>
+#include <algorithm>
 #include <limits>
+#include <optional>
+#include <tuple>
 
 namespace dice {
 namespace tables {
 
 
 /*
- * simple description of table id
+ * simple description of table id,
+ * history tables are rings, slot of row with id is given by RingLayout
  * */
 struct TableId
 {
     uint64_t first; // id of first row stored in table
     uint64_t last;  // id of last row stored in table
-    uint64_t max;   // visible frame size
+    uint64_t max;   // visible frame size, amount of slots in ring
+
+    static constexpr uint64_t ring_end = 1ull << 63; // rows with greater primary key are not part of ring
 
     uint64_t next()
     {
@@ -41,11 +48,71 @@ struct TableId
         eosio::print_f("[first=% last=% max=%]", first, last, max);
     }
 
+    bool operator==(const TableId& other) const
+    {
+        return std::tie(first, last, max) == std::tie(other.first, other.last, other.max);
+    }
+
+    bool operator!=(const TableId& other) const
+    {
+        return !(*this == other);
+    }
+
     EOSLIB_SERIALIZE(TableId,
         (first)(last)(max)
     );
 };
 
+/*
+ * placement of history ring in primary key space: row with id is stored in slot base + id % max.
+ * Resize moves ring to fresh slots after the current ones, rows of previous ring stay in their slots
+ * and are removed in id order when they leave visible frame (see add_ring_record).
+ * */
+struct RingLayout
+{
+    uint64_t base;      // first slot of ring
+    uint64_t old_base;  // first slot of previous ring
+    uint64_t old_max;   // amount of slots in previous ring, 0 when it has no rows left
+    uint64_t old_last;  // id of last row written to previous ring
+    uint64_t gc_next;   // id of next row of previous ring to remove
+    bool legacy;        // legacy rows of table are not moved to ring yet by bets.migrate
+
+    // ring starting at base without previous ring
+    static RingLayout start(uint64_t base, bool legacy)
+    {
+        return RingLayout{base, 0, 0, 0, 0, legacy};
+    }
+
+    bool has_old_rows() const
+    {
+        return 0 != old_max;
+    }
+
+    uint64_t slot(const TableId& tbl_id, uint64_t id) const
+    {
+        if(has_old_rows() && id <= old_last)
+        {
+            return old_base + id % old_max;
+        }
+        return base + id % tbl_id.max;
+    }
+
+    bool operator==(const RingLayout& other) const
+    {
+        return std::tie(base, old_base, old_max, old_last, gc_next, legacy) ==
+               std::tie(other.base, other.old_base, other.old_max, other.old_last, other.gc_next, other.legacy);
+    }
+
+    bool operator!=(const RingLayout& other) const
+    {
+        return !(*this == other);
+    }
+
+    EOSLIB_SERIALIZE(RingLayout,
+        (base)(old_base)(old_max)(old_last)(gc_next)(legacy)
+    );
+};
+
 /*
  * leader board config
  * */
@@ -103,6 +170,18 @@ struct LeaderBoardConfig
                 period_start.sec_since_epoch(), period_length);
     }
 
+    bool operator==(const LeaderBoardConfig& other) const
+    {
+        return std::tie(size, bonus_percent, distribution_id, distribution_start, period_start, period_length) ==
+               std::tie(other.size, other.bonus_percent, other.distribution_id, other.distribution_start,
+                        other.period_start, other.period_length);
+    }
+
+    bool operator!=(const LeaderBoardConfig& other) const
+    {
+        return !(*this == other);
+    }
+
     EOSLIB_SERIALIZE(LeaderBoardConfig,
         (size)
         (bonus_percent)
@@ -115,7 +194,105 @@ struct LeaderBoardConfig
 
 
 /*
- * Table to store main config.
+ * Table to store hot part of main config, fields are changed by every bet.
+ */
+struct [[eosio::table("cfg.state"), eosio::contract("eos.dice")]] State
+{
+    eosio::asset eos_balance;                   // eos_balance
+    TableId bets_id;                            // id for table bets.all
+    TableId high_bets_id;                       // id for table bets.high
+    TableId rare_bets_id;                       // id for table bets.rare
+    eosio::asset jackpot_balance;               // jackpot balance
+    eosio::asset total_payout;                  // total payout
+    eosio::asset total_bet_amount;              // total bet amount
+    uint64_t base_deferred_id;
+    RingLayout bets_layout;                     // slots of table bets.all
+    RingLayout high_bets_layout;                // slots of table bets.high
+    RingLayout rare_bets_layout;                // slots of table bets.rare
+
+    bool operator==(const State& other) const
+    {
+        return std::tie(eos_balance, bets_id, high_bets_id, rare_bets_id, jackpot_balance, total_payout,
+                        total_bet_amount, base_deferred_id, bets_layout, high_bets_layout, rare_bets_layout) ==
+               std::tie(other.eos_balance, other.bets_id, other.high_bets_id, other.rare_bets_id,
+                        other.jackpot_balance, other.total_payout, other.total_bet_amount, other.base_deferred_id,
+                        other.bets_layout, other.high_bets_layout, other.rare_bets_layout);
+    }
+
+    bool operator!=(const State& other) const
+    {
+        return !(*this == other);
+    }
+
+    EOSLIB_SERIALIZE(State,
+        (eos_balance)
+        (bets_id)
+        (high_bets_id)
+        (rare_bets_id)
+        (jackpot_balance)
+        (total_payout)
+        (total_bet_amount)
+        (base_deferred_id)
+        (bets_layout)
+        (high_bets_layout)
+        (rare_bets_layout)
+    )
+};
+typedef eosio::singleton<"cfg.state"_n, State> ContractState;
+
+/*
+ * Table to store cold part of main config, fields are changed by setters and leader boards.
+ */
+struct [[eosio::table("cfg.settings"), eosio::contract("eos.dice")]] Settings
+{
+    eosio::name owner;                          // contract owner
+    eosio::name admin;                          // contract admin
+    eosio::name ante_token;                     // ante.token contract owner
+    bool enabled_betting;                       // set false to disable betting
+    bool enabled_minting;                       // set false to disable token minting
+    bool enabled_payout;                        // set false to disable payout on win
+    eosio::asset high_bet_bound;                // lower bound of High Bets
+    uint16_t rare_bet_bound;                    // upper bound for possible wins (for Rare Bets)
+    double ante_in_eos;                         // how many ante tokens in 1 EOS
+    double referral_multiplier;                 // i.e. 10% of loosing bets will be added to referrer shadow balance
+    double jackpot_percent;                     // jackpot percent for each bet
+
+    LeaderBoardConfig day_leader_board;         // configuration for day leader board
+    LeaderBoardConfig month_leader_board;       // configuration for month leader board
+
+    bool operator==(const Settings& other) const
+    {
+        return std::tie(owner, admin, ante_token, enabled_betting, enabled_minting, enabled_payout, high_bet_bound,
+                        rare_bet_bound, ante_in_eos, referral_multiplier, jackpot_percent, day_leader_board,
+                        month_leader_board) ==
+               std::tie(other.owner, other.admin, other.ante_token, other.enabled_betting, other.enabled_minting,
+                        other.enabled_payout, other.high_bet_bound, other.rare_bet_bound, other.ante_in_eos,
+                        other.referral_multiplier, other.jackpot_percent, other.day_leader_board,
+                        other.month_leader_board);
+    }
+
+    bool operator!=(const Settings& other) const
+    {
+        return !(*this == other);
+    }
+
+    EOSLIB_SERIALIZE(Settings,
+        (owner)(admin)(ante_token)
+        (enabled_betting)(enabled_minting)(enabled_payout)
+        (high_bet_bound)
+        (rare_bet_bound)
+        (ante_in_eos)
+        (referral_multiplier)
+        (jackpot_percent)
+        (day_leader_board)
+        (month_leader_board)
+    )
+};
+typedef eosio::singleton<"cfg.settings"_n, Settings> ContractSettings;
+
+/*
+ * Main config: all fields in one place, stored as cfg.state and cfg.settings.
+ * Table cfg.main keeps legacy layout until it is migrated by cfg.migrate.
  */
 struct [[eosio::table("cfg.main"), eosio::contract("eos.dice")]] Config
 {
@@ -141,6 +318,9 @@ struct [[eosio::table("cfg.main"), eosio::contract("eos.dice")]] Config
     LeaderBoardConfig day_leader_board;         // configuration for day leader board
     LeaderBoardConfig month_leader_board;       // configuration for month leader board
     uint64_t base_deferred_id;
+    RingLayout bets_layout;                     // slots of table bets.all, not stored in cfg.main
+    RingLayout high_bets_layout;                // slots of table bets.high, not stored in cfg.main
+    RingLayout rare_bets_layout;                // slots of table bets.rare, not stored in cfg.main
 
     void print() const
     {
@@ -151,6 +331,12 @@ struct [[eosio::table("cfg.main"), eosio::contract("eos.dice")]] Config
                        month_leader_board);
     }
 
+    // bets are accepted only when all history tables are migrated
+    bool is_history_migrated() const
+    {
+        return !bets_layout.legacy && !high_bets_layout.legacy && !rare_bets_layout.legacy;
+    }
+
     inline uint128_t next_deferred_id(uint8_t nested_action_number)
     {
         ++base_deferred_id;
@@ -158,6 +344,70 @@ struct [[eosio::table("cfg.main"), eosio::contract("eos.dice")]] Config
         return deferred_id;
     }
 
+    State get_state() const
+    {
+        return State{eos_balance, bets_id, high_bets_id, rare_bets_id, jackpot_balance, total_payout,
+                     total_bet_amount, base_deferred_id, bets_layout, high_bets_layout, rare_bets_layout};
+    }
+
+    void set_state(const State& state)
+    {
+        eos_balance = state.eos_balance;
+        bets_id = state.bets_id;
+        high_bets_id = state.high_bets_id;
+        rare_bets_id = state.rare_bets_id;
+        jackpot_balance = state.jackpot_balance;
+        total_payout = state.total_payout;
+        total_bet_amount = state.total_bet_amount;
+        base_deferred_id = state.base_deferred_id;
+        bets_layout = state.bets_layout;
+        high_bets_layout = state.high_bets_layout;
+        rare_bets_layout = state.rare_bets_layout;
+    }
+
+    Settings get_settings() const
+    {
+        return Settings{owner, admin, ante_token, enabled_betting, enabled_minting, enabled_payout, high_bet_bound,
+                        rare_bet_bound, ante_in_eos, referral_multiplier, jackpot_percent, day_leader_board,
+                        month_leader_board};
+    }
+
+    void set_settings(const Settings& settings)
+    {
+        owner = settings.owner;
+        admin = settings.admin;
+        ante_token = settings.ante_token;
+        enabled_betting = settings.enabled_betting;
+        enabled_minting = settings.enabled_minting;
+        enabled_payout = settings.enabled_payout;
+        high_bet_bound = settings.high_bet_bound;
+        rare_bet_bound = settings.rare_bet_bound;
+        ante_in_eos = settings.ante_in_eos;
+        referral_multiplier = settings.referral_multiplier;
+        jackpot_percent = settings.jackpot_percent;
+        day_leader_board = settings.day_leader_board;
+        month_leader_board = settings.month_leader_board;
+    }
+
+    bool operator==(const Config& other) const
+    {
+        return std::tie(owner, admin, ante_token, enabled_betting, enabled_minting, enabled_payout, eos_balance,
+                        bets_id, high_bets_id, rare_bets_id, high_bet_bound, rare_bet_bound, ante_in_eos,
+                        referral_multiplier, jackpot_percent, jackpot_balance, total_payout, total_bet_amount,
+                        day_leader_board, month_leader_board, base_deferred_id) ==
+               std::tie(other.owner, other.admin, other.ante_token, other.enabled_betting, other.enabled_minting,
+                        other.enabled_payout, other.eos_balance, other.bets_id, other.high_bets_id,
+                        other.rare_bets_id, other.high_bet_bound, other.rare_bet_bound, other.ante_in_eos,
+                        other.referral_multiplier, other.jackpot_percent, other.jackpot_balance,
+                        other.total_payout, other.total_bet_amount, other.day_leader_board,
+                        other.month_leader_board, other.base_deferred_id);
+    }
+
+    bool operator!=(const Config& other) const
+    {
+        return !(*this == other);
+    }
+
     EOSLIB_SERIALIZE(Config,
         (owner)(admin)(ante_token)
         (enabled_betting)(enabled_minting)(enabled_payout)
@@ -202,6 +452,17 @@ struct [[eosio::table("ante.bonuses"), eosio::contract("eos.dice")]] AnteBonus
 };
 typedef eosio::multi_index<"ante.bonuses"_n, AnteBonus> AnteBonusesConfig;
 
+/*
+ * Ante minting bonuses compiled from ante.bonuses table for lookup by binary search.
+ */
+struct [[eosio::table("ante.tiers"), eosio::contract("eos.dice")]] AnteBonusTiers
+{
+    std::vector<AnteBonus> tiers;           // non overlapping tiers sorted by begin
+
+    EOSLIB_SERIALIZE(AnteBonusTiers, (tiers))
+};
+typedef eosio::singleton<"ante.tiers"_n, AnteBonusTiers> AnteBonusTiersConfig;
+
 /*
  * Table for dice game limits
 */
@@ -222,11 +483,37 @@ struct [[eosio::table("dice.limits"), eosio::contract("eos.dice")]] DiceLimit
                 (int)min_value, (int)max_value, max_bet_percent, (int)max_bet_num, min_bet,
                 balance_protect, platform_fee);
     }
+
+    bool operator==(const DiceLimit& other) const
+    {
+        return std::tie(min_value, max_value, max_bet_percent, max_bet_num, min_bet, balance_protect, platform_fee) ==
+               std::tie(other.min_value, other.max_value, other.max_bet_percent, other.max_bet_num, other.min_bet,
+                        other.balance_protect, other.platform_fee);
+    }
+
+    bool operator!=(const DiceLimit& other) const
+    {
+        return !(*this == other);
+    }
     EOSLIB_SERIALIZE(DiceLimit,
             (min_value)(max_value)(max_bet_percent)(max_bet_num)(min_bet)(balance_protect)(platform_fee))
 };
 typedef eosio::singleton<"dice.limits"_n, DiceLimit> DiceLimits;
 
+/*
+ * Table of fixed point payout multipliers indexed by amount of winning numbers,
+ * built from dice limits whenever platform fee or game params are changed
+*/
+struct [[eosio::table("payout.tbl"), eosio::contract("eos.dice")]] PayoutTable
+{
+    static constexpr uint8_t precision_bits = rules::payout_precision_bits;
+
+    std::vector<uint64_t> multipliers;  // (1 - platform_fee) * (100 / num) * 2^precision_bits
+
+    EOSLIB_SERIALIZE(PayoutTable, (multipliers))
+};
+typedef eosio::singleton<"payout.tbl"_n, PayoutTable> PayoutTables;
+
 /*
  * Table for income token statistics
 */
@@ -243,6 +530,17 @@ struct [[eosio::table("bet.tokens"), eosio::contract("eos.dice")]] BetToken
         return name.raw();
     };
 
+    bool operator==(const BetToken& other) const
+    {
+        return std::tie(name, in, out, bets, wons) ==
+               std::tie(other.name, other.in, other.out, other.bets, other.wons);
+    }
+
+    bool operator!=(const BetToken& other) const
+    {
+        return !(*this == other);
+    }
+
     EOSLIB_SERIALIZE(BetToken,
             (name)(in)(out)(bets)(wons)
     );
@@ -250,9 +548,220 @@ struct [[eosio::table("bet.tokens"), eosio::contract("eos.dice")]] BetToken
 typedef eosio::singleton<"bet.tokens"_n, BetToken> BetTokens;
 
 /*
- * Table with history of bets
+ * Bet resolution engines
+*/
+namespace ResolveMode {
+    enum : uint8_t {
+        DEFERRED = 0,   // on_transfer -> deferred `bet` -> deferred `resolved`
+        REVEAL = 1,     // on_transfer stores pending bet -> `reveal` of its house seed by anyone resolves it
+        BATCH = 2       // as REVEAL, `resolve.batch` reveals house seed for many pending bets at once
+    };
+}
+
+/*
+ * Table for bet resolution settings,
+ * bet placed while house_commitment is sha256(seed k) is resolved by seed k + 1 of the hash chain,
+ * seed k + 1 can be revealed only in a later block than seed k, so it is unknown in the block of the bet
+ * even when reveal of seed k is already seen before it is included
+*/
+struct [[eosio::table("cfg.resolve"), eosio::contract("eos.dice")]] ResolveConfig
+{
+    uint8_t mode;                       // one of ResolveMode
+    capi_checksum256 house_commitment;  // sha256 of next house seed, house seeds form a hash chain
+    uint32_t reveal_timeout;            // seconds after which player can refund unrevealed bet
+    uint64_t revealed_time;             // block time in microseconds when chain was moved forward last time
+
+    static constexpr uint32_t min_reveal_timeout = 5 * 60;
+    static constexpr uint32_t default_reveal_timeout = 60 * 60;
+
+    EOSLIB_SERIALIZE(ResolveConfig,
+            (mode)(house_commitment)(reveal_timeout)(revealed_time)
+    );
+};
+typedef eosio::singleton<"cfg.resolve"_n, ResolveConfig> ResolveConfigs;
+
+/*
+ * Table with bets waiting for resolution,
+ * bets of REVEAL and BATCH modes share one table in contract scope, ordered by id,
+ * so bets committed to one house seed are consecutive
+*/
+struct [[eosio::table("pending"), eosio::contract("eos.dice")]] PendingBet
+{
+    uint64_t id;                        // pending bet id
+    eosio::name player;                 // account who placed bet
+    eosio::name inviter;                // another player who gave referral id to this player
+    eosio::asset quantity;              // bet amount "1.0001 EOS"
+    uint8_t roll_type;                  // 1 || 2
+    uint16_t roll_border;               // roll border ie: 50
+    capi_checksum256 user_seed;         // hash of transaction with bet
+    capi_checksum256 house_commitment;  // house commitment when bet was placed, sha256(sha256(seed)) of its seed
+    eosio::time_point_sec time;         // time point in seconds
+    uint8_t rolls;                      // number of rolls, quantity is amount of one roll
+    bool is_session;                    // bet is paid from player balance, refund is credited back to it
+
+    uint64_t primary_key() const
+    {
+        return id;
+    };
+
+    EOSLIB_SERIALIZE(PendingBet,
+        (id)(player)(inviter)(quantity)(roll_type)(roll_border)(user_seed)(house_commitment)(time)(rolls)
+        (is_session)
+    );
+};
+typedef eosio::multi_index<"bets.pending"_n, PendingBet> PendingBets;
+
+/*
+ * Table with prepaid player balances:
+ * bet.session bets are paid from balance, winnings of players with balance are credited here
+*/
+struct [[eosio::table("balance"), eosio::contract("eos.dice")]] Balance
+{
+    eosio::name player;                 // balance owner
+    eosio::asset balance;               // available amount "1.0001 EOS"
+
+    uint64_t primary_key() const
+    {
+        return player.value;
+    };
+
+    EOSLIB_SERIALIZE(Balance,
+        (player)(balance)
+    );
+};
+typedef eosio::multi_index<"balances"_n, Balance> Balances;
+
+/*
+ * Table with ANTE amounts waiting for mint,
+ * amounts are accumulated per player and inviter and minted by one deferred transaction per `mint.flush`,
+ * row is flushed when its amount or age reaches threshold, so bets of active players only update their rows
+*/
+struct [[eosio::table("mint"), eosio::contract("eos.dice")]] PendingMint
+{
+    // max number of mint actions in one deferred transaction
+    static constexpr uint16_t flush_size = 20;
+    // row with at least this amount is flushed, "100.0000 ANTE"
+    static constexpr int64_t flush_amount = 1000000;
+    // row older than this is flushed, in seconds
+    static constexpr uint32_t flush_age = 3600;
+
+    uint64_t id;                        // pending mint id
+    eosio::name player;                 // account who receives tokens
+    eosio::name inviter;                // another player who gave referral id to this player
+    eosio::asset quantity;              // amount to mint "1.0001 ANTE"
+    eosio::time_point_sec time;         // time of first accumulated amount
+
+    uint64_t primary_key() const
+    {
+        return id;
+    };
+
+    uint128_t by_recipient() const
+    {
+        return recipient_key(player, inviter);
+    };
+
+    static uint128_t recipient_key(const eosio::name& player, const eosio::name& inviter)
+    {
+        return (uint128_t(player.value) << 64) | inviter.value;
+    }
+
+    EOSLIB_SERIALIZE(PendingMint,
+        (id)(player)(inviter)(quantity)(time)
+    );
+};
+typedef eosio::multi_index<"mint.pending"_n, PendingMint,
+        eosio::indexed_by<"byrecipient"_n, eosio::const_mem_fun<PendingMint, uint128_t, &PendingMint::by_recipient>>>
+        PendingMints;
+
+/*
+ * Table with history of bets, compact format:
+ * amounts are stored without symbol (always EOS), seed is stored only in bets.all
 */
 struct [[eosio::table("bet"), eosio::contract("eos.dice")]] Bet
+{
+    static constexpr uint8_t current_version = 1;
+
+    // history tables which reference bet
+    enum Pin: uint8_t
+    {
+        PIN_HIGH = 1,
+        PIN_RARE = 2
+    };
+
+    uint64_t slot;                      // slot in ring given by RingLayout, or pinned_slot(id)
+    uint64_t id;                        // bet number in history
+    uint8_t version;                    // format version of record
+    uint8_t pins;                       // combination of Pin flags, pinned bet is kept when ring overwrites it
+    eosio::name player;                 // account who placed bet
+    uint8_t roll_type;                  // 1 || 2
+    uint16_t roll_border;               // roll border ie: 50
+    uint16_t roll_value;                // roll value ie: 42
+    int64_t bet;                        // bet amount in EOS ie: 10001 means "1.0001 EOS"
+    int64_t payout;                     // payout amount in EOS
+    eosio::name inviter;                // another player who gave referral id to this player
+    std::optional<capi_checksum256> seed; // seed which was used to generate random value
+    uint16_t seed_word;                 // 0: roll is second word of seed % max, n: word n - 1 of random stream of seed
+    eosio::time_point_sec time;         // time point in seconds
+
+    uint64_t primary_key() const
+    {
+        return slot;
+    };
+
+    uint64_t by_player() const
+    {
+        return player.value;
+    };
+
+    // slot of bet moved out of ring
+    static uint64_t pinned_slot(uint64_t id)
+    {
+        return TableId::ring_end | id;
+    }
+
+    // id of bet copied to bets.all from legacy bets.high or bets.rare row, legacy rows are not linked to bets.all
+    static uint64_t legacy_ref_id(uint64_t legacy_id, uint8_t pin)
+    {
+        return (1ull << 62) | (uint64_t(pin) << 56) | legacy_id;
+    }
+
+    EOSLIB_SERIALIZE(Bet,
+        (slot)(id)(version)(pins)(player)(roll_type)(roll_border)(roll_value)(bet)(payout)(inviter)(seed)(seed_word)
+        (time)
+    );
+
+};
+
+typedef eosio::multi_index<"bets.all"_n, Bet,
+        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<Bet, uint64_t, &Bet::by_player>>> Bets;
+
+/*
+ * Table with references to bets stored in bets.all
+*/
+struct [[eosio::table("betref"), eosio::contract("eos.dice")]] BetRef
+{
+    uint64_t slot;                      // slot in ring given by RingLayout
+    uint64_t bet_id;                    // id of bet in bets.all
+    uint64_t sort_key;                  // bets.high: bet amount, bets.rare: payout amount
+
+    uint64_t primary_key() const
+    {
+        return slot;
+    };
+
+    EOSLIB_SERIALIZE(BetRef, (slot)(bet_id)(sort_key));
+};
+
+typedef eosio::multi_index<"bets.high"_n, BetRef> HighBets;
+
+typedef eosio::multi_index<"bets.rare"_n, BetRef> RareBets;
+
+/*
+ * Previous format of bets history, used only by migration:
+ * rows are keyed by id, bets.high and bets.rare store full copies numbered by their own ids
+*/
+struct LegacyBet
 {
     uint64_t id;                        // bet number in history
     eosio::name player;                 // account who placed bet
@@ -260,7 +769,7 @@ struct [[eosio::table("bet"), eosio::contract("eos.dice")]] Bet
     uint64_t roll_border;               // roll border ie: 50
     uint64_t roll_value;                // roll value ie: 42
     eosio::asset bet;                   // bet amount "1.0001 EOS"
-    std::vector<eosio::asset> payout;   // payouts use vector for future usage ie: ["1.0001 EOS", "1.0001 EOS", ..]
+    std::vector<eosio::asset> payout;   // payouts
     eosio::name inviter;                // another player who gave referral id to this player
     capi_checksum256 seed;              // seed which was used to generate random value
     eosio::time_point_sec time;         // time point in seconds
@@ -275,20 +784,19 @@ struct [[eosio::table("bet"), eosio::contract("eos.dice")]] Bet
         return player.value;
     };
 
-    EOSLIB_SERIALIZE(Bet,
+    EOSLIB_SERIALIZE(LegacyBet,
         (id)(player)(roll_type)(roll_border)(roll_value)(bet)(payout)(inviter)(seed)(time)
     );
-
 };
 
-typedef eosio::multi_index<"bets.all"_n, Bet,
-        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<Bet, uint64_t, &Bet::by_player>>> Bets;
+typedef eosio::multi_index<"bets.all"_n, LegacyBet,
+        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<LegacyBet, uint64_t, &LegacyBet::by_player>>> LegacyBets;
 
-typedef eosio::multi_index<"bets.high"_n, Bet,
-        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<Bet, uint64_t, &Bet::by_player>>> HighBets;
+typedef eosio::multi_index<"bets.high"_n, LegacyBet,
+        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<LegacyBet, uint64_t, &LegacyBet::by_player>>> LegacyHighBets;
 
-typedef eosio::multi_index<"bets.rare"_n, Bet,
-        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<Bet, uint64_t, &Bet::by_player>>> RareBets;
+typedef eosio::multi_index<"bets.rare"_n, LegacyBet,
+        eosio::indexed_by<"byplayer"_n, eosio::const_mem_fun<LegacyBet, uint64_t, &LegacyBet::by_player>>> LegacyRareBets;
 
 
 /*
@@ -368,37 +876,46 @@ struct [[eosio::table("player"), eosio::contract("eos.dice")]] Player
         return account.value;
     };
 
-    uint64_t by_day_bets()const
+    /*
+     * secondary keys are tagged with number of period of last bet in high bits,
+     * so rows of current period form one contiguous range of index,
+     * keys depend on period lengths from config and are defined in eos.dice.cpp
+     *
+     * key = period_number(last_bet_time, period_length) << 40 | min(value, 2^40 - 1)
+     * leaders of period p are read backwards from index.lower_bound(period_key(p + 1, 0))
+     * while key >= period_key(p, 0), rows with older periods have stale values and are skipped
+     * */
+    static constexpr uint64_t period_key_bits = 40;
+
+    static uint64_t period_number(eosio::time_point time, uint32_t period_length)
     {
-        return day.total_bet_amount;
-    }
-    uint64_t by_day_bets_count()const
-    {
-        return day.bets;
-    }
-    uint64_t by_week_bets()const
-    {
-        return week.total_bet_amount;
-    }
-    uint64_t by_week_bets_count()const
-    {
-        return week.bets;
-    }
-    uint64_t by_month_bets()const
-    {
-        return month.total_bet_amount;
+        return time.sec_since_epoch() / period_length;
     }
 
-    uint64_t by_month_bets_count()const
+    static uint64_t period_key(uint64_t period, uint64_t value)
     {
-        return month.bets;
+        constexpr uint64_t value_mask = (1ull << period_key_bits) - 1;
+        return (period << period_key_bits) | std::min(value, value_mask);
     }
 
+    uint64_t by_day_bets()const;
+    uint64_t by_day_bets_count()const;
+    uint64_t by_week_bets()const;
+    uint64_t by_week_bets_count()const;
+    uint64_t by_month_bets()const;
+    uint64_t by_month_bets_count()const;
+
     EOSLIB_SERIALIZE(Player,
             (account)(last_bet_time)(last_bet)(last_payout)(jackpot_sequence)(jackpot_sequence_values)(total)(day)(week)(month)
     );
 };
 
+/*
+ * Every player secondary index costs additional db operations on each bet,
+ * by default only indexes used by leader boards are maintained,
+ * build with PLAYERS_ALL_INDEXES to maintain all of them
+*/
+#ifdef PLAYERS_ALL_INDEXES
 typedef eosio::multi_index<"players"_n, Player,
         eosio::indexed_by<"bydayb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_day_bets>>,
         eosio::indexed_by<"bydaybc"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_day_bets_count>>,
@@ -407,6 +924,24 @@ typedef eosio::multi_index<"players"_n, Player,
         eosio::indexed_by<"bymonthb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_month_bets>>,
         eosio::indexed_by<"bymonthbc"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_month_bets_count>>
     > Players;
+#else
+typedef eosio::multi_index<"players"_n, Player,
+        eosio::indexed_by<"bydayb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_day_bets>>,
+        eosio::indexed_by<"bymonthb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_month_bets>>
+    > Players;
+#endif
+
+/*
+ * Players with all secondary indexes ever used, needed to rebuild indexes of existing rows
+*/
+typedef eosio::multi_index<"players"_n, Player,
+        eosio::indexed_by<"bydayb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_day_bets>>,
+        eosio::indexed_by<"bydaybc"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_day_bets_count>>,
+        eosio::indexed_by<"byweekb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_week_bets>>,
+        eosio::indexed_by<"byweekbc"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_week_bets_count>>,
+        eosio::indexed_by<"bymonthb"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_month_bets>>,
+        eosio::indexed_by<"bymonthbc"_n, eosio::const_mem_fun<Player, uint64_t, &Player::by_month_bets_count>>
+    > LegacyPlayers;
 
 /*
  * Top stats for period (day\month)
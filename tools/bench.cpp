@@ -0,0 +1,389 @@
+/*
+ * Per action cost benchmark of eos.dice on the in-memory chain of tools/native.
+ *
+ * Every scenario drives the contract through the same actions as on chain and reports, per action handler,
+ * average intrinsic counters (db, secondary index, sha256, bytes written to rows and sent in actions,
+ * inline and deferred actions) and wall time. Counters are deterministic for given parameters, so output
+ * with time=0 can be diffed between commits to catch regressions on the bet path.
+ *
+ * build:
+ *     g++ -O2 -std=gnu++17 -Wno-attributes -I tools/native -I<directory containing dice/> tools/bench.cpp -o bench
+ * run:
+ *     bench bets=10000 batches=1,10,50,100 time=1
+ *
+ * parameters:
+ *     bets                         bet transfers per scenario
+ *     warmup                       bets placed before measurements, fill bets history and player rows
+ *     players                      amount of players, bets are placed round robin
+ *     per_block                    bets placed in one block (one second)
+ *     batches                      resolve.batch sizes, each size is a separate scenario
+ *     setters                      calls of every setter action
+ *     seed                         seed of house seeds and bet borders
+ *     time                         0 omits wall time column
+ * */
+#include <dice_chain.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace dice::host;
+using eosio::native::Counters;
+
+struct Params
+{
+    uint64_t bets = 10000;
+    uint64_t warmup = 2000;
+    uint32_t players = 100;
+    uint32_t per_block = 50;
+    std::vector<uint16_t> batches{1, 10, 50, 100, 250};
+    uint32_t setters = 100;
+    uint64_t seed = 1;
+    bool time = true;
+};
+
+bool parse_batches(const std::string& value, std::vector<uint16_t>& batches)
+{
+    batches.clear();
+    size_t pos = 0;
+    while(pos <= value.size())
+    {
+        auto end = value.find(',', pos);
+        if(end == std::string::npos)
+        {
+            end = value.size();
+        }
+        auto size = std::strtoul(value.substr(pos, end - pos).c_str(), nullptr, 10);
+        if(size == 0 || size > std::numeric_limits<uint16_t>::max())
+        {
+            return false;
+        }
+        batches.push_back(uint16_t(size));
+        pos = end + 1;
+    }
+    return !batches.empty();
+}
+
+bool parse_args(int argc, char** argv, Params& params)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if(eq == std::string::npos)
+        {
+            std::fprintf(stderr, "wrong argument %s\n", argv[i]);
+            return false;
+        }
+        auto key = arg.substr(0, eq);
+        auto value = arg.substr(eq + 1);
+        const char* v = value.c_str();
+        if(key == "bets") params.bets = std::max(1ull, std::strtoull(v, nullptr, 10));
+        else if(key == "warmup") params.warmup = std::strtoull(v, nullptr, 10);
+        else if(key == "players") params.players = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "per_block") params.per_block = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "setters") params.setters = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "seed") params.seed = std::strtoull(v, nullptr, 10);
+        else if(key == "time") params.time = std::atoi(v) != 0;
+        else if(key == "batches")
+        {
+            if(!parse_batches(value, params.batches))
+            {
+                std::fprintf(stderr, "wrong batches %s\n", v);
+                return false;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown parameter %s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+class Bench
+{
+public:
+    explicit Bench(const Params& params) : _params(params), _rng(params.seed)
+    {
+        deploy(params.players);
+    }
+
+    void print_header() const
+    {
+        std::printf("%-14s %-24s %8s", "scenario", "action", "calls");
+        Counters::for_each_counter([](const char* name, uint64_t Counters::*)
+        {
+            std::printf(" %12s", name);
+        });
+        if(_params.time)
+        {
+            std::printf(" %12s", "us/call");
+        }
+        std::printf("\n");
+    }
+
+    // bets which are not measured, history ring and player rows reach their steady state
+    void warmup()
+    {
+        set_mode(dice::tables::ResolveMode::DEFERRED);
+        place_bets(_params.warmup);
+        settle();
+    }
+
+    void deferred()
+    {
+        set_mode(dice::tables::ResolveMode::DEFERRED);
+        begin();
+        place_bets(_params.bets);
+        settle();
+        end("deferred", _params.bets);
+    }
+
+    // every block reveals one seed, which resolves bets of previous block
+    void reveal()
+    {
+        uint64_t blocks = (_params.bets + _params.per_block - 1) / _params.per_block;
+        HouseSeeds house_seeds(blocks + 1, _params.seed);
+        set_mode(dice::tables::ResolveMode::REVEAL);
+        check(admin("commit.set"_n, dice_account, house_seeds.commitment()));
+        begin();
+        for(uint64_t placed = 0; placed <= _params.bets; placed += _params.per_block)
+        {
+            if(placed < _params.bets)
+            {
+                place_bets(std::min<uint64_t>(_params.per_block, _params.bets - placed));
+            }
+            const auto& house_seed = house_seeds.next();
+            auto ids = pending_bets(house_seed);
+            for(auto id: ids)
+            {
+                check(admin("reveal"_n, id, house_seed));
+            }
+            if(ids.empty())
+            {
+                check(admin("resolve.batch"_n, uint16_t(1), house_seed));
+            }
+            chain().produce(1);
+        }
+        settle();
+        end("reveal", _params.bets);
+    }
+
+    // every round places size bets and resolves bets of previous round by one resolve.batch
+    void batch(uint16_t size)
+    {
+        uint64_t rounds = (_params.bets + size - 1) / size;
+        HouseSeeds house_seeds(rounds + 1, _params.seed);
+        set_mode(dice::tables::ResolveMode::BATCH);
+        check(admin("commit.set"_n, dice_account, house_seeds.commitment()));
+        begin();
+        for(uint64_t placed = 0; placed <= _params.bets; placed += size)
+        {
+            if(placed < _params.bets)
+            {
+                place_bets(std::min<uint64_t>(size, _params.bets - placed));
+            }
+            const auto& house_seed = house_seeds.next();
+            do
+            {
+                check(admin("resolve.batch"_n, size, house_seed));
+            }
+            while(!pending_bets(house_seed).empty());
+            chain().produce(1);
+        }
+        settle();
+        end("batch/" + std::to_string(size), _params.bets);
+    }
+
+    void session()
+    {
+        set_mode(dice::tables::ResolveMode::DEFERRED);
+        begin();
+        for(uint32_t i = 0; i < _params.players; ++i)
+        {
+            check(transfer(player_name(i), dice_account, eos(100000000), "deposit"));
+        }
+        for(uint64_t placed = 0; placed < _params.bets;)
+        {
+            for(uint32_t i = 0; i < _params.per_block && placed < _params.bets; ++i, ++placed)
+            {
+                auto player = player_name(uint32_t(placed % _params.players));
+                check(chain().push(player, dice_account, "bet.session"_n, player, eos(10000), uint8_t(1),
+                        uint16_t(next_border()), eosio::name(), uint8_t(1)));
+            }
+            chain().produce(2);
+        }
+        for(uint32_t i = 0; i < _params.players; ++i)
+        {
+            auto player = player_name(i);
+            check(chain().push(player, dice_account, "withdraw"_n, player, eos(10000)));
+        }
+        settle();
+        end("session", _params.bets);
+    }
+
+    // setters write the values they read, so following scenarios are not affected
+    void setters()
+    {
+        begin();
+        for(uint32_t i = 0; i < _params.setters; ++i)
+        {
+            check(admin("fee.set"_n, dice_account, 0.015));
+            check(admin("minbet.set"_n, dice_account, eos(1000)));
+            check(admin("mbp.set"_n, dice_account, 0.02));
+            check(admin("params.set"_n, dice_account, uint16_t(1), uint16_t(100), uint16_t(100)));
+            check(admin("rate.set"_n, dice_account, 1.0));
+            check(admin("jackpot.set"_n, dice_account, 0.005));
+            check(admin("referral.set"_n, dice_account, 0.1));
+            check(admin("high.bet.set"_n, dice_account, eos(100000)));
+            check(admin("rare.bet.set"_n, dice_account, uint16_t(5)));
+            check(admin("betting.set"_n, dice_account, true));
+            check(admin("bonus.set"_n, dice_account, uint16_t(51), uint16_t(1000), 2.0));
+        }
+        end("setters");
+    }
+
+    int failures() const
+    {
+        return _failures;
+    }
+
+private:
+    void check(const eosio::native::Chain::Result& result)
+    {
+        if(!result.ok)
+        {
+            if(0 == _failures)
+            {
+                std::fprintf(stderr, "first failure: %s\n", result.error.c_str());
+            }
+            ++_failures;
+        }
+    }
+
+    uint64_t next_border()
+    {
+        return 2 + _rng() % 97;
+    }
+
+    void set_mode(uint8_t mode)
+    {
+        check(admin("resolve.set"_n, dice_account, mode, uint32_t(3600)));
+    }
+
+    void place_bets(uint64_t count)
+    {
+        auto& c = chain();
+        for(uint64_t placed = 0; placed < count;)
+        {
+            for(uint32_t i = 0; i < _params.per_block && placed < count; ++i, ++placed)
+            {
+                auto player = player_name(uint32_t(_next_player++ % _params.players));
+                check(transfer(player, dice_account, eos(10000), "bet,1," + std::to_string(next_border())));
+            }
+            if(placed < count)
+            {
+                c.produce(1);
+            }
+        }
+    }
+
+    // runs deferred transactions which are left by scenario
+    void settle()
+    {
+        auto& c = chain();
+        do
+        {
+            c.produce(1);
+        } while(c.pending_deferred() > 0);
+    }
+
+    void begin()
+    {
+        chain().reset_action_stats();
+        chain().set_profiling(true);
+    }
+
+    // rows of dice action handlers, then their sum per bet when scenario places bets
+    void end(const std::string& scenario, uint64_t bets = 0)
+    {
+        auto& c = chain();
+        c.set_profiling(false);
+        eosio::native::Chain::ActionStats total;
+        for(const auto& entry: c.action_stats())
+        {
+            uint64_t receiver, code, action;
+            std::tie(receiver, code, action) = entry.first;
+            if(receiver != dice_account.value)
+            {
+                continue;
+            }
+            auto label = eosio::name(action).to_string();
+            if(code != receiver)
+            {
+                label = eosio::name(code).to_string() + "::" + label;
+            }
+            print_row(scenario, label, entry.second.calls, entry.second);
+            total.counters += entry.second.counters;
+            total.seconds += entry.second.seconds;
+        }
+        if(bets > 0)
+        {
+            print_row(scenario, "total/bet", bets, total);
+        }
+    }
+
+    void print_row(const std::string& scenario, const std::string& label, uint64_t calls,
+            const eosio::native::Chain::ActionStats& stats)
+    {
+        std::printf("%-14s %-24s %8lu", scenario.c_str(), label.c_str(), calls);
+        Counters::for_each_counter([&](const char*, uint64_t Counters::* field)
+        {
+            std::printf(" %12.2f", double(stats.counters.*field) / calls);
+        });
+        if(_params.time)
+        {
+            std::printf(" %12.2f", stats.seconds * 1e6 / calls);
+        }
+        std::printf("\n");
+    }
+
+    const Params& _params;
+    std::mt19937_64 _rng;
+    uint64_t _next_player = 0;
+    int _failures = 0;
+};
+
+}//namespace
+
+int main(int argc, char** argv)
+{
+    Params params;
+    if(!parse_args(argc, argv, params))
+    {
+        return 1;
+    }
+    Bench bench(params);
+    bench.print_header();
+    bench.warmup();
+    bench.deferred();
+    bench.reveal();
+    for(auto size: params.batches)
+    {
+        bench.batch(size);
+    }
+    bench.session();
+    bench.setters();
+    if(bench.failures() > 0)
+    {
+        std::fprintf(stderr, "%d transactions failed\n", bench.failures());
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,561 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dice {
+namespace columnar {
+
+/*
+ * Compact append-only columnar file for exported tables.
+ *
+ * file:   "DICECOL1" | uint32 version | uint32 schema size | schema | padding to 8
+ * schema: uint16 table name size | table name | uint16 columns | columns: uint8 type, uint16 name size, name
+ * chunk:  "CHNK" | uint32 rows | for every column: uint64 size | values | padding to 8
+ *
+ * Values are little endian arrays of fixed width, STRING column is (rows + 1) uint32 offsets followed by bytes.
+ * Writer appends chunks to the end of existing file with the same schema, reader ignores truncated last chunk,
+ * so file stays readable when export is interrupted, writer cuts it off before appending.
+ * */
+
+enum class Type : uint8_t
+{
+    U8 = 1,
+    U16,
+    U32,
+    U64,
+    I32,
+    I64,
+    BYTES32,
+    STRING
+};
+
+inline size_t type_size(Type type)
+{
+    switch(type)
+    {
+        case Type::U8: return 1;
+        case Type::U16: return 2;
+        case Type::U32: case Type::I32: return 4;
+        case Type::U64: case Type::I64: return 8;
+        case Type::BYTES32: return 32;
+        default: return 0;
+    }
+}
+
+struct Column
+{
+    std::string name;
+    Type type;
+
+    bool operator==(const Column& other) const
+    {
+        return name == other.name && type == other.type;
+    }
+};
+
+struct Schema
+{
+    std::string table;
+    std::vector<Column> columns;
+
+    size_t find(std::string_view name) const
+    {
+        for(size_t i = 0; i < columns.size(); ++i)
+        {
+            if(columns[i].name == name)
+            {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    bool operator==(const Schema& other) const
+    {
+        return table == other.table && columns == other.columns;
+    }
+
+    static constexpr size_t npos = size_t(-1);
+};
+
+/*
+ * schemas mirroring contract tables, names of columns are names of fields,
+ * names are stored as uint64 values, assets as amounts, time_point in microseconds, time_point_sec in seconds
+ * */
+inline Schema bet_schema()
+{
+    return Schema{"bets.all", {
+        {"slot", Type::U64}, {"id", Type::U64}, {"version", Type::U8}, {"pins", Type::U8},
+        {"player", Type::U64}, {"roll_type", Type::U8}, {"roll_border", Type::U16}, {"roll_value", Type::U16},
+        {"bet", Type::I64}, {"payout", Type::I64}, {"inviter", Type::U64}, {"has_seed", Type::U8},
+        {"seed", Type::BYTES32}, {"seed_word", Type::U16}, {"time", Type::U32}
+    }};
+}
+
+// bets.high and bets.rare
+inline Schema bet_ref_schema(const std::string& table)
+{
+    return Schema{table, {{"slot", Type::U64}, {"bet_id", Type::U64}, {"sort_key", Type::U64}}};
+}
+
+inline Schema player_schema()
+{
+    Schema schema{"players", {
+        {"account", Type::U64}, {"last_bet_time", Type::I64}, {"last_bet", Type::I64}, {"last_payout", Type::I64},
+        {"jackpot_sequence", Type::I32}, {"jackpot_sequence_values", Type::STRING}
+    }};
+    for(const char* period: {"total", "day", "week", "month"})
+    {
+        for(const char* field: {"total_bet_amount", "total_payout", "bets", "wons"})
+        {
+            schema.columns.push_back(Column{std::string(period) + "." + field, Type::U64});
+        }
+    }
+    return schema;
+}
+
+inline Schema jackpot_schema()
+{
+    return Schema{"jackpots", {{"id", Type::U64}, {"player", Type::U64}, {"time", Type::I64}, {"amount", Type::I64}}};
+}
+
+namespace detail {
+
+constexpr char file_magic[8] = {'D', 'I', 'C', 'E', 'C', 'O', 'L', '1'};
+constexpr char chunk_magic[4] = {'C', 'H', 'N', 'K'};
+constexpr uint32_t version = 1;
+
+inline size_t padding(size_t size)
+{
+    return (8 - size % 8) % 8;
+}
+
+inline void append(std::vector<uint8_t>& out, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+template<class T>
+void append_value(std::vector<uint8_t>& out, T value)
+{
+    append(out, &value, sizeof(value));
+}
+
+inline std::vector<uint8_t> encode_header(const Schema& schema)
+{
+    std::vector<uint8_t> body;
+    append_value<uint16_t>(body, schema.table.size());
+    append(body, schema.table.data(), schema.table.size());
+    append_value<uint16_t>(body, schema.columns.size());
+    for(const auto& column: schema.columns)
+    {
+        append_value<uint8_t>(body, uint8_t(column.type));
+        append_value<uint16_t>(body, column.name.size());
+        append(body, column.name.data(), column.name.size());
+    }
+    std::vector<uint8_t> header;
+    append(header, file_magic, sizeof(file_magic));
+    append_value<uint32_t>(header, version);
+    append_value<uint32_t>(header, body.size());
+    append(header, body.data(), body.size());
+    header.resize(header.size() + padding(header.size()), 0);
+    return header;
+}
+
+struct truncated_error: std::runtime_error
+{
+    truncated_error() : std::runtime_error("unexpected end of columnar file") {}
+};
+
+class Cursor
+{
+public:
+    Cursor(const uint8_t* data, size_t size) : _data(data), _size(size), _pos(0) {}
+
+    template<class T>
+    T read()
+    {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const uint8_t* take(size_t size)
+    {
+        if(size > _size - _pos)
+        {
+            throw truncated_error();
+        }
+        auto result = _data + _pos;
+        _pos += size;
+        return result;
+    }
+
+    size_t position() const
+    {
+        return _pos;
+    }
+
+    size_t left() const
+    {
+        return _size - _pos;
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _pos;
+};
+
+// returns schema and size of header
+inline size_t decode_header(const uint8_t* data, size_t size, Schema& schema)
+{
+    Cursor cursor(data, size);
+    if(0 != std::memcmp(cursor.take(sizeof(file_magic)), file_magic, sizeof(file_magic)))
+    {
+        throw std::runtime_error("not a columnar file");
+    }
+    if(cursor.read<uint32_t>() != version)
+    {
+        throw std::runtime_error("unsupported columnar file version");
+    }
+    auto body_size = cursor.read<uint32_t>();
+    Cursor body(cursor.take(body_size), body_size);
+    auto table_size = body.read<uint16_t>();
+    schema.table.assign(reinterpret_cast<const char*>(body.take(table_size)), table_size);
+    auto columns = body.read<uint16_t>();
+    schema.columns.clear();
+    for(uint16_t i = 0; i < columns; ++i)
+    {
+        auto type = Type(body.read<uint8_t>());
+        auto name_size = body.read<uint16_t>();
+        std::string name(reinterpret_cast<const char*>(body.take(name_size)), name_size);
+        schema.columns.push_back(Column{name, type});
+    }
+    return cursor.position() + padding(cursor.position());
+}
+
+}//namespace detail
+
+/*
+ * memory mapped reader, columns of chunk are arrays pointing into the mapping
+ * */
+class Reader
+{
+public:
+    struct Chunk
+    {
+        uint32_t rows;
+        std::vector<const uint8_t*> columns;
+
+        template<class T>
+        const T* values(size_t column) const
+        {
+            return reinterpret_cast<const T*>(columns[column]);
+        }
+
+        std::string_view string(size_t column, size_t row) const
+        {
+            auto offsets = values<uint32_t>(column);
+            auto bytes = reinterpret_cast<const char*>(offsets + rows + 1);
+            return std::string_view(bytes + offsets[row], offsets[row + 1] - offsets[row]);
+        }
+    };
+
+    explicit Reader(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st;
+        if(0 != ::fstat(fd, &st) || st.st_size == 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("cannot read " + path);
+        }
+        _size = st.st_size;
+        void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(data == MAP_FAILED)
+        {
+            throw std::runtime_error("cannot map " + path);
+        }
+        _data = static_cast<const uint8_t*>(data);
+        ::madvise(data, _size, MADV_SEQUENTIAL);
+        index(detail::decode_header(_data, _size, _schema));
+    }
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    ~Reader()
+    {
+        ::munmap(const_cast<uint8_t*>(_data), _size);
+    }
+
+    const Schema& schema() const
+    {
+        return _schema;
+    }
+
+    const std::vector<Chunk>& chunks() const
+    {
+        return _chunks;
+    }
+
+    uint64_t rows() const
+    {
+        uint64_t result = 0;
+        for(const auto& chunk: _chunks)
+        {
+            result += chunk.rows;
+        }
+        return result;
+    }
+
+    // size of header and complete chunks, bytes after it are left by interrupted export
+    size_t complete_size() const
+    {
+        return _complete_size;
+    }
+
+private:
+    // walks chunk headers, truncated last chunk is ignored
+    void index(size_t offset)
+    {
+        offset = std::min(offset, _size);
+        _complete_size = offset;
+        detail::Cursor cursor(_data + offset, _size - offset);
+        try
+        {
+            while(cursor.left() > 0)
+            {
+                if(0 != std::memcmp(cursor.take(sizeof(detail::chunk_magic)), detail::chunk_magic,
+                        sizeof(detail::chunk_magic)))
+                {
+                    throw std::runtime_error("corrupted chunk");
+                }
+                Chunk chunk;
+                chunk.rows = cursor.read<uint32_t>();
+                for(const auto& column: _schema.columns)
+                {
+                    auto size = cursor.read<uint64_t>();
+                    chunk.columns.push_back(cursor.take(size));
+                    cursor.take(detail::padding(size));
+                    auto width = type_size(column.type);
+                    if(width != 0 ? size != uint64_t(width) * chunk.rows : size < (chunk.rows + 1) * sizeof(uint32_t))
+                    {
+                        throw std::runtime_error("wrong size of column " + column.name);
+                    }
+                }
+                _chunks.push_back(std::move(chunk));
+                _complete_size = offset + cursor.position();
+            }
+        }
+        catch(const detail::truncated_error&)
+        {
+        }
+    }
+
+    const uint8_t* _data;
+    size_t _size;
+    Schema _schema;
+    std::vector<Chunk> _chunks;
+    size_t _complete_size;
+};
+
+/*
+ * buffers rows column by column and writes one chunk per chunk_rows rows
+ * */
+class Writer
+{
+public:
+    Writer(const std::string& path, const Schema& schema, size_t chunk_rows = 1 << 16)
+        : _schema(schema), _chunk_rows(chunk_rows), _rows(0), _columns(schema.columns.size()),
+          _offsets(schema.columns.size())
+    {
+        auto header = detail::encode_header(schema);
+        struct stat st;
+        bool exists = 0 == ::stat(path.c_str(), &st) && st.st_size > 0;
+        bool has_header = exists;
+        if(exists)
+        {
+            // appending to existing file requires the same schema
+            size_t complete_size = 0;
+            {
+                Reader reader(path);
+                if(!(reader.schema() == schema))
+                {
+                    throw std::runtime_error("schema of " + path + " differs");
+                }
+                complete_size = reader.complete_size();
+            }
+            // truncated last chunk of interrupted export would hide chunks appended after it,
+            // file cut in padding of header is written again
+            has_header = complete_size >= header.size();
+            size_t keep = has_header ? complete_size : 0;
+            if(keep != size_t(st.st_size) && 0 != ::truncate(path.c_str(), keep))
+            {
+                throw std::runtime_error("cannot truncate " + path);
+            }
+        }
+        _file = std::fopen(path.c_str(), "ab");
+        if(!_file)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        if(!has_header)
+        {
+            write(header.data(), header.size());
+        }
+        reset_offsets();
+    }
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // destructor cannot report errors, close() must be called to know that all rows are written
+    ~Writer()
+    {
+        try
+        {
+            close();
+        }
+        catch(const std::exception&)
+        {
+        }
+    }
+
+    const Schema& schema() const
+    {
+        return _schema;
+    }
+
+    void set(size_t column, uint64_t value)
+    {
+        auto size = type_size(_schema.columns[column].type);
+        detail::append(_columns[column], &value, size);
+    }
+
+    void set_signed(size_t column, int64_t value)
+    {
+        set(column, uint64_t(value));
+    }
+
+    void set_bytes(size_t column, const uint8_t* value)
+    {
+        detail::append(_columns[column], value, type_size(Type::BYTES32));
+    }
+
+    void set_string(size_t column, std::string_view value)
+    {
+        detail::append(_columns[column], value.data(), value.size());
+        _offsets[column].push_back(_columns[column].size());
+    }
+
+    // every column must be set once per row
+    void end_row()
+    {
+        if(++_rows == _chunk_rows)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if(_rows == 0)
+        {
+            return;
+        }
+        write(detail::chunk_magic, sizeof(detail::chunk_magic));
+        uint32_t rows = _rows;
+        write(&rows, sizeof(rows));
+        for(size_t i = 0; i < _columns.size(); ++i)
+        {
+            bool is_string = _schema.columns[i].type == Type::STRING;
+            uint64_t size = _columns[i].size() + (is_string ? _offsets[i].size() * sizeof(uint32_t) : 0);
+            write(&size, sizeof(size));
+            if(is_string)
+            {
+                write(_offsets[i].data(), _offsets[i].size() * sizeof(uint32_t));
+            }
+            write(_columns[i].data(), _columns[i].size());
+            static const uint8_t zeros[8] = {};
+            write(zeros, detail::padding(size));
+            _columns[i].clear();
+        }
+        if(0 != std::fflush(_file))
+        {
+            throw std::runtime_error("write failed");
+        }
+        _rows = 0;
+        reset_offsets();
+    }
+
+    // writes buffered rows and closes file, rows must not be added after close
+    void close()
+    {
+        if(!_file)
+        {
+            return;
+        }
+        FILE* file = _file;
+        try
+        {
+            flush();
+        }
+        catch(const std::exception&)
+        {
+            _file = nullptr;
+            std::fclose(file);
+            throw;
+        }
+        _file = nullptr;
+        if(0 != std::fclose(file))
+        {
+            throw std::runtime_error("write failed");
+        }
+    }
+
+private:
+    void write(const void* data, size_t size)
+    {
+        if(size != std::fwrite(data, 1, size, _file))
+        {
+            throw std::runtime_error("write failed");
+        }
+    }
+
+    void reset_offsets()
+    {
+        for(auto& offsets: _offsets)
+        {
+            offsets.assign(1, 0);
+        }
+    }
+
+    Schema _schema;
+    size_t _chunk_rows;
+    size_t _rows;
+    std::vector<std::vector<uint8_t>> _columns;
+    std::vector<std::vector<uint32_t>> _offsets;
+    FILE* _file;
+};
+
+}//namespace columnar
+}//namespace dice
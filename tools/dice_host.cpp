@@ -0,0 +1,225 @@
+/*
+ * Native build of eos.dice against the in-memory chain of tools/native.
+ *
+ * The contract sources are compiled unchanged by the host compiler: tools/native/eosiolib replaces eosiolib,
+ * tools/native/dice provides the headers which are not part of this repository (common, config, leaderboards,
+ * logger), tools/native/chain.hpp implements intrinsics. Bets are placed by eosio.token transfers with bet memo
+ * and resolved in the selected mode, every action runs through the same dispatch as on chain.
+ *
+ * build:
+ *     g++ -O2 -std=gnu++17 -Wno-attributes -I tools/native -I<directory containing dice/> tools/dice_host.cpp -o dice_host
+ * run:
+ *     dice_host bets=100000 players=100 mode=deferred
+ *
+ * parameters:
+ *     bets                         amount of bet transfers
+ *     players                      amount of players, bets are placed round robin
+ *     per_block                    bets placed in one block (one second)
+ *     mode                         deferred | reveal | batch
+ *     batch                        max bets resolved by one resolve.batch
+ *     rolls                        rolls per bet transfer
+ *     crank                        blocks between mint.flush calls, 0 disables them
+ *     seed                         seed of house seeds and bet borders
+ *     verbose                      1 prints console of failed transactions
+ * */
+#include <dice_chain.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace {
+
+using namespace dice::host;
+
+enum class Mode
+{
+    DEFERRED,
+    REVEAL,
+    BATCH
+};
+
+struct Params
+{
+    uint64_t bets = 100000;
+    uint32_t players = 100;
+    uint32_t per_block = 50;
+    Mode mode = Mode::DEFERRED;
+    uint16_t batch = 50;
+    uint32_t rolls = 1;
+    uint32_t crank = 60;
+    uint64_t seed = 1;
+    bool verbose = false;
+};
+
+bool parse_args(int argc, char** argv, Params& params)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if(eq == std::string::npos)
+        {
+            std::fprintf(stderr, "wrong argument %s\n", argv[i]);
+            return false;
+        }
+        auto key = arg.substr(0, eq);
+        auto value = arg.substr(eq + 1);
+        const char* v = value.c_str();
+        if(key == "bets") params.bets = std::strtoull(v, nullptr, 10);
+        else if(key == "players") params.players = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "per_block") params.per_block = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "batch") params.batch = uint16_t(std::max(1ul, std::strtoul(v, nullptr, 10)));
+        else if(key == "rolls") params.rolls = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "crank") params.crank = std::strtoul(v, nullptr, 10);
+        else if(key == "seed") params.seed = std::strtoull(v, nullptr, 10);
+        else if(key == "verbose") params.verbose = std::atoi(v) != 0;
+        else if(key == "mode")
+        {
+            if(value == "deferred") params.mode = Mode::DEFERRED;
+            else if(value == "reveal") params.mode = Mode::REVEAL;
+            else if(value == "batch") params.mode = Mode::BATCH;
+            else
+            {
+                std::fprintf(stderr, "wrong mode %s\n", v);
+                return false;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown parameter %s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Stats
+{
+    uint64_t placed = 0;
+    uint64_t failed = 0;
+    uint64_t resolve_failed = 0;
+    std::string last_error;
+
+    void check(const eosio::native::Chain::Result& result, bool resolve, bool verbose)
+    {
+        if(result.ok)
+        {
+            return;
+        }
+        ++(resolve ? resolve_failed : failed);
+        last_error = result.error;
+        if(verbose)
+        {
+            std::fprintf(stderr, "failed: %s\n%s", result.error.c_str(), chain().console().c_str());
+        }
+    }
+};
+
+}//namespace
+
+int main(int argc, char** argv)
+{
+    Params params;
+    if(!parse_args(argc, argv, params))
+    {
+        return 1;
+    }
+    auto& c = chain();
+    c.set_console_echo(false);
+    Stats stats;
+    deploy(params.players);
+
+    uint64_t blocks = (params.bets + params.per_block - 1) / params.per_block;
+    // seed revealed in block resolves bets of previous block, so the last bets need one more block
+    HouseSeeds house_seeds(params.mode == Mode::DEFERRED ? 0 : blocks + 1, params.seed);
+    if(params.mode != Mode::DEFERRED)
+    {
+        uint8_t mode = params.mode == Mode::REVEAL ? dice::tables::ResolveMode::REVEAL : dice::tables::ResolveMode::BATCH;
+        stats.check(admin("resolve.set"_n, dice_account, mode, uint32_t(3600)), true, true);
+        stats.check(admin("commit.set"_n, dice_account, house_seeds.commitment()), true, true);
+    }
+
+    std::mt19937_64 rng(params.seed);
+    const auto quantity = eos(10000 * params.rolls);
+    c.reset_counters();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t placed = 0;
+    for(uint64_t block = 0; block < blocks + (params.mode == Mode::DEFERRED ? 0 : 1); ++block)
+    {
+        for(uint32_t i = 0; i < params.per_block && placed < params.bets; ++i, ++placed)
+        {
+            auto player = player_name(uint32_t(placed % params.players));
+            auto border = 2 + rng() % 97;
+            auto memo = "bet,1," + std::to_string(border);
+            if(params.rolls > 1)
+            {
+                memo += ",,x" + std::to_string(params.rolls);
+            }
+            stats.check(transfer(player, dice_account, quantity, memo), false, params.verbose);
+        }
+        if(params.crank && block % params.crank == params.crank - 1)
+        {
+            stats.check(admin("mint.flush"_n, dice_account, dice::tables::PendingMint::flush_size), true,
+                    params.verbose);
+        }
+        switch(params.mode)
+        {
+            case Mode::DEFERRED:
+                // bet and resolved are delayed by one second each
+                c.produce(2);
+                break;
+            case Mode::REVEAL:
+            {
+                // bets of previous block are committed to the same seed, the first reveal advances the chain,
+                // block without those bets advances it by an empty batch
+                const auto& house_seed = house_seeds.next();
+                auto ids = pending_bets(house_seed);
+                for(auto id: ids)
+                {
+                    stats.check(admin("reveal"_n, id, house_seed), true, params.verbose);
+                }
+                if(ids.empty())
+                {
+                    stats.check(admin("resolve.batch"_n, uint16_t(1), house_seed), true, params.verbose);
+                }
+                c.produce(1);
+                break;
+            }
+            case Mode::BATCH:
+            {
+                const auto& house_seed = house_seeds.next();
+                do
+                {
+                    stats.check(admin("resolve.batch"_n, params.batch, house_seed), true, params.verbose);
+                }
+                while(!pending_bets(house_seed).empty());
+                c.produce(1);
+                break;
+            }
+        }
+    }
+    while(c.pending_deferred() > 0)
+    {
+        c.produce(1);
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.placed = params.bets - stats.failed;
+
+    std::printf("bets=%lu failed=%lu resolve_failed=%lu seconds=%.3f bets_per_second=%.0f\n",
+            stats.placed, stats.failed, stats.resolve_failed, elapsed, stats.placed / elapsed);
+    if(!stats.last_error.empty())
+    {
+        std::printf("last error: %s\n", stats.last_error.c_str());
+    }
+    const auto& counters = c.counters();
+    eosio::native::Counters::for_each_counter([&](const char* name, uint64_t eosio::native::Counters::* field)
+    {
+        std::printf("%-14s %12lu %10.2f/bet\n", name, counters.*field,
+                stats.placed ? double(counters.*field) / stats.placed : 0.0);
+    });
+    std::printf("dice EOS balance %s, ram %ld bytes\n",
+            c.balance(dice_account, common::EOS_SYMBOL).to_string().c_str(), c.ram_usage(dice_account));
+    return stats.failed + stats.resolve_failed == 0 ? 0 : 2;
+}
@@ -0,0 +1,525 @@
+/*
+ * Converter of table JSON dumps to columnar files and scanner of columnar files.
+ *
+ * build:
+ *     g++ -O2 -std=c++17 tools/export_tool.cpp -o export_tool
+ * run:
+ *     export_tool convert <bets.all|bets.high|bets.rare|players|jackpots> <out.dcol> <dump.json>...
+ *     export_tool stat <file.dcol>
+ *
+ * dumps are outputs of "cleos get table" ({"rows": [...], "more": ...}) or plain arrays of rows,
+ * rows of every dump are appended to the output file, so paged dumps can be converted one by one.
+ * stat scans all columns and prints amount of rows, sums of numeric columns and scan speed.
+ * */
+#include "columnar.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+using namespace dice::columnar;
+
+/*
+ * minimal JSON value, numbers are kept as text to preserve uint64 precision
+ * */
+struct Value
+{
+    enum Kind
+    {
+        NUL,
+        BOOL,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Kind kind = NUL;
+    std::string text;
+    std::vector<Value> items;
+    std::vector<std::pair<std::string, Value>> fields;
+
+    const Value& operator[](const std::string& key) const
+    {
+        static const Value null;
+        for(const auto& field: fields)
+        {
+            if(field.first == key)
+            {
+                return field.second;
+            }
+        }
+        return null;
+    }
+};
+
+class Parser
+{
+public:
+    explicit Parser(const std::string& text) : _text(text), _pos(0) {}
+
+    /*
+     * calls f for every row of dump without keeping all rows in memory
+     * */
+    void rows(const std::function<void(const Value&)>& f)
+    {
+        skip_spaces();
+        if(peek() == '[')
+        {
+            array(f);
+            return;
+        }
+        expect('{');
+        skip_spaces();
+        if(peek() == '}')
+        {
+            return;
+        }
+        while(true)
+        {
+            auto key = string();
+            skip_spaces();
+            expect(':');
+            skip_spaces();
+            if(key == "rows")
+            {
+                array(f);
+            }
+            else
+            {
+                value();
+            }
+            skip_spaces();
+            if(peek() == ',')
+            {
+                ++_pos;
+                skip_spaces();
+                continue;
+            }
+            expect('}');
+            return;
+        }
+    }
+
+private:
+    void array(const std::function<void(const Value&)>& f)
+    {
+        expect('[');
+        skip_spaces();
+        if(peek() == ']')
+        {
+            ++_pos;
+            return;
+        }
+        while(true)
+        {
+            skip_spaces();
+            f(value());
+            skip_spaces();
+            if(peek() == ',')
+            {
+                ++_pos;
+                continue;
+            }
+            expect(']');
+            return;
+        }
+    }
+
+    Value value()
+    {
+        skip_spaces();
+        Value result;
+        char c = peek();
+        if(c == '{')
+        {
+            result.kind = Value::OBJECT;
+            ++_pos;
+            skip_spaces();
+            if(peek() == '}')
+            {
+                ++_pos;
+                return result;
+            }
+            while(true)
+            {
+                skip_spaces();
+                auto key = string();
+                skip_spaces();
+                expect(':');
+                result.fields.emplace_back(key, value());
+                skip_spaces();
+                if(peek() == ',')
+                {
+                    ++_pos;
+                    continue;
+                }
+                expect('}');
+                return result;
+            }
+        }
+        if(c == '[')
+        {
+            result.kind = Value::ARRAY;
+            array([&](const Value& item) { result.items.push_back(item); });
+            return result;
+        }
+        if(c == '"')
+        {
+            result.kind = Value::STRING;
+            result.text = string();
+            return result;
+        }
+        if(_text.compare(_pos, 4, "null") == 0)
+        {
+            _pos += 4;
+            return result;
+        }
+        if(_text.compare(_pos, 4, "true") == 0 || _text.compare(_pos, 5, "false") == 0)
+        {
+            result.kind = Value::BOOL;
+            result.text = c == 't' ? "true" : "false";
+            _pos += result.text.size();
+            return result;
+        }
+        result.kind = Value::NUMBER;
+        auto start = _pos;
+        while(_pos < _text.size() && std::strchr("+-0123456789.eE", _text[_pos]))
+        {
+            ++_pos;
+        }
+        if(start == _pos)
+        {
+            fail("value expected");
+        }
+        result.text = _text.substr(start, _pos - start);
+        return result;
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::string result;
+        while(_pos < _text.size() && _text[_pos] != '"')
+        {
+            char c = _text[_pos++];
+            if(c == '\\' && _pos < _text.size())
+            {
+                char e = _text[_pos++];
+                switch(e)
+                {
+                    case 'n': result += '\n'; break;
+                    case 't': result += '\t'; break;
+                    case 'r': result += '\r'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'u': result += '?'; _pos += 4; break;
+                    default: result += e;
+                }
+            }
+            else
+            {
+                result += c;
+            }
+        }
+        expect('"');
+        return result;
+    }
+
+    char peek() const
+    {
+        return _pos < _text.size() ? _text[_pos] : '\0';
+    }
+
+    void expect(char c)
+    {
+        if(peek() != c)
+        {
+            fail(std::string("'") + c + "' expected");
+        }
+        ++_pos;
+    }
+
+    void skip_spaces()
+    {
+        while(_pos < _text.size() && std::strchr(" \t\r\n", _text[_pos]))
+        {
+            ++_pos;
+        }
+    }
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error("json: " + message + " at " + std::to_string(_pos));
+    }
+
+    const std::string& _text;
+    size_t _pos;
+};
+
+uint64_t to_u64(const Value& value)
+{
+    return std::strtoull(value.text.c_str(), nullptr, 10);
+}
+
+int64_t to_i64(const Value& value)
+{
+    return std::strtoll(value.text.c_str(), nullptr, 10);
+}
+
+// eosio name encoding: 12 characters of 5 bits and 13th character of 4 bits
+uint64_t to_name(const Value& value)
+{
+    auto symbol = [](char c) -> uint64_t
+    {
+        if(c >= 'a' && c <= 'z') return c - 'a' + 6;
+        if(c >= '1' && c <= '5') return c - '1' + 1;
+        return 0;
+    };
+    const auto& str = value.text;
+    uint64_t result = 0;
+    for(size_t i = 0; i < str.size() && i < 13; ++i)
+    {
+        if(i < 12)
+        {
+            result |= (symbol(str[i]) & 0x1f) << (64 - 5 * (i + 1));
+        }
+        else
+        {
+            result |= symbol(str[i]) & 0x0f;
+        }
+    }
+    return result;
+}
+
+// "1.0001 EOS" -> 10001
+int64_t to_amount(const Value& value)
+{
+    int64_t result = 0;
+    bool negative = false;
+    for(char c: value.text)
+    {
+        if(c == ' ')
+        {
+            break;
+        }
+        if(c == '-')
+        {
+            negative = true;
+        }
+        else if(c >= '0' && c <= '9')
+        {
+            result = result * 10 + (c - '0');
+        }
+    }
+    return negative ? -result : result;
+}
+
+// "2019-01-01T00:00:00.000" -> microseconds since epoch
+int64_t to_microseconds(const Value& value)
+{
+    int year = 1970, month = 1, day = 1, hour = 0, minute = 0, second = 0, millisecond = 0;
+    std::sscanf(value.text.c_str(), "%d-%d-%dT%d:%d:%d.%d", &year, &month, &day, &hour, &minute, &second,
+            &millisecond);
+    // days from civil date
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64_t days = era * 146097 + day_of_era - 719468;
+    return ((days * 86400 + hour * 3600 + minute * 60 + second) * 1000 + millisecond) * 1000;
+}
+
+bool to_checksum(const Value& value, uint8_t* out)
+{
+    if(value.kind != Value::STRING || value.text.size() != 64)
+    {
+        return false;
+    }
+    for(size_t i = 0; i < 32; ++i)
+    {
+        out[i] = uint8_t(std::strtoul(value.text.substr(2 * i, 2).c_str(), nullptr, 16));
+    }
+    return true;
+}
+
+/*
+ * writes one row of table to columns in schema order
+ * */
+void write_bet(Writer& writer, const Value& row)
+{
+    uint8_t seed[32] = {};
+    bool has_seed = to_checksum(row["seed"], seed);
+    writer.set(0, to_u64(row["slot"]));
+    writer.set(1, to_u64(row["id"]));
+    writer.set(2, to_u64(row["version"]));
+    writer.set(3, to_u64(row["pins"]));
+    writer.set(4, to_name(row["player"]));
+    writer.set(5, to_u64(row["roll_type"]));
+    writer.set(6, to_u64(row["roll_border"]));
+    writer.set(7, to_u64(row["roll_value"]));
+    writer.set_signed(8, to_i64(row["bet"]));
+    writer.set_signed(9, to_i64(row["payout"]));
+    writer.set(10, to_name(row["inviter"]));
+    writer.set(11, has_seed);
+    writer.set_bytes(12, seed);
+    writer.set(13, to_u64(row["seed_word"]));
+    writer.set(14, to_microseconds(row["time"]) / 1000000);
+}
+
+void write_bet_ref(Writer& writer, const Value& row)
+{
+    writer.set(0, to_u64(row["slot"]));
+    writer.set(1, to_u64(row["bet_id"]));
+    writer.set(2, to_u64(row["sort_key"]));
+}
+
+void write_player(Writer& writer, const Value& row)
+{
+    writer.set(0, to_name(row["account"]));
+    writer.set_signed(1, to_microseconds(row["last_bet_time"]));
+    writer.set_signed(2, to_amount(row["last_bet"]));
+    writer.set_signed(3, to_amount(row["last_payout"]));
+    writer.set_signed(4, to_i64(row["jackpot_sequence"]));
+    writer.set_string(5, row["jackpot_sequence_values"].text);
+    size_t column = 6;
+    for(const char* period: {"total", "day", "week", "month"})
+    {
+        const auto& stats = row[period];
+        for(const char* field: {"total_bet_amount", "total_payout", "bets", "wons"})
+        {
+            writer.set(column++, to_u64(stats[field]));
+        }
+    }
+}
+
+void write_jackpot(Writer& writer, const Value& row)
+{
+    writer.set(0, to_u64(row["id"]));
+    writer.set(1, to_name(row["player"]));
+    writer.set_signed(2, to_microseconds(row["time"]));
+    writer.set_signed(3, to_amount(row["amount"]));
+}
+
+int convert(const std::string& table, const std::string& out, const std::vector<std::string>& dumps)
+{
+    Schema schema;
+    void (*write_row)(Writer&, const Value&) = nullptr;
+    if(table == "bets.all")
+    {
+        schema = bet_schema();
+        write_row = write_bet;
+    }
+    else if(table == "bets.high" || table == "bets.rare")
+    {
+        schema = bet_ref_schema(table);
+        write_row = write_bet_ref;
+    }
+    else if(table == "players")
+    {
+        schema = player_schema();
+        write_row = write_player;
+    }
+    else if(table == "jackpots")
+    {
+        schema = jackpot_schema();
+        write_row = write_jackpot;
+    }
+    else
+    {
+        std::fprintf(stderr, "unknown table %s\n", table.c_str());
+        return 2;
+    }
+
+    Writer writer(out, schema);
+    uint64_t rows = 0;
+    for(const auto& dump: dumps)
+    {
+        std::ifstream in(dump, std::ios::binary);
+        if(!in)
+        {
+            std::fprintf(stderr, "cannot open %s\n", dump.c_str());
+            return 2;
+        }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        Parser(text).rows([&](const Value& row)
+        {
+            write_row(writer, row);
+            writer.end_row();
+            ++rows;
+        });
+    }
+    writer.close();
+    std::printf("table=%s rows=%llu\n", table.c_str(), (unsigned long long)rows);
+    return 0;
+}
+
+int print_stats(const std::string& path)
+{
+    auto started = std::chrono::steady_clock::now();
+    Reader reader(path);
+    const auto& columns = reader.schema().columns;
+    std::vector<uint64_t> sums(columns.size(), 0);
+    uint64_t bytes = 0;
+    for(const auto& chunk: reader.chunks())
+    {
+        for(size_t c = 0; c < columns.size(); ++c)
+        {
+            uint64_t sum = 0;
+            switch(columns[c].type)
+            {
+                case Type::U8: { auto v = chunk.values<uint8_t>(c); for(uint32_t r = 0; r < chunk.rows; ++r) sum += v[r]; break; }
+                case Type::U16: { auto v = chunk.values<uint16_t>(c); for(uint32_t r = 0; r < chunk.rows; ++r) sum += v[r]; break; }
+                case Type::U32: { auto v = chunk.values<uint32_t>(c); for(uint32_t r = 0; r < chunk.rows; ++r) sum += v[r]; break; }
+                case Type::I32: { auto v = chunk.values<int32_t>(c); for(uint32_t r = 0; r < chunk.rows; ++r) sum += v[r]; break; }
+                case Type::U64: case Type::I64: { auto v = chunk.values<uint64_t>(c); for(uint32_t r = 0; r < chunk.rows; ++r) sum += v[r]; break; }
+                case Type::STRING: { for(uint32_t r = 0; r < chunk.rows; ++r) sum += chunk.string(c, r).size(); break; }
+                default: break;
+            }
+            sums[c] += sum;
+            bytes += uint64_t(chunk.rows) * type_size(columns[c].type);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("table=%s rows=%llu chunks=%zu\n", reader.schema().table.c_str(),
+            (unsigned long long)reader.rows(), reader.chunks().size());
+    for(size_t c = 0; c < columns.size(); ++c)
+    {
+        if(columns[c].type != Type::BYTES32)
+        {
+            std::printf("sum %s=%lld\n", columns[c].name.c_str(), (long long)sums[c]);
+        }
+    }
+    std::printf("scanned_mb=%.1f seconds=%.3f\n", bytes / 1e6, seconds);
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if(argc >= 5 && std::string(argv[1]) == "convert")
+        {
+            return convert(argv[2], argv[3], std::vector<std::string>(argv + 4, argv + argc));
+        }
+        if(argc == 3 && std::string(argv[1]) == "stat")
+        {
+            return print_stats(argv[2]);
+        }
+    }
+    catch(const std::exception& error)
+    {
+        std::fprintf(stderr, "%s\n", error.what());
+        return 2;
+    }
+    std::fprintf(stderr, "usage: export_tool convert <table> <out.dcol> <dump.json>...\n"
+                         "       export_tool stat <file.dcol>\n");
+    return 2;
+}
@@ -0,0 +1,157 @@
+/*
+ * Micro-benchmark of bet memo parsing: memo::parse_bet against the former split + atoi path of on_bet.
+ *
+ * The split path is a copy of the code which parsed memo before memo.hpp, common::split is reproduced
+ * with the same algorithm. Both parsers run over the same memos, heap allocations are counted by
+ * replacing global operator new.
+ *
+ * build:
+ *     g++ -O2 -std=gnu++17 -I tools/native -I<directory containing dice/> tools/memo_bench.cpp -o memo_bench
+ * run:
+ *     memo_bench iterations=1000000
+ *
+ * parameters:
+ *     iterations                   parses of every memo by every parser
+ * */
+#include <dice/memo.hpp>
+#include <chain.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+uint64_t allocations = 0;
+
+}//namespace
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if(void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace {
+
+// common::split: tokens between delimiters, empty tokens are skipped
+void split(const std::string& str, std::vector<std::string>& tokens, const std::string& delimiters)
+{
+    auto last = str.find_first_not_of(delimiters, 0);
+    auto pos = str.find_first_of(delimiters, last);
+    while(std::string::npos != pos || std::string::npos != last)
+    {
+        tokens.push_back(str.substr(last, pos - last));
+        last = str.find_first_not_of(delimiters, pos);
+        pos = str.find_first_of(delimiters, last);
+    }
+}
+
+// memo parsing of on_bet before memo.hpp
+dice::memo::BetMemo parse_split(const std::string& memo)
+{
+    std::vector<std::string> pieces;
+    split(memo, pieces, ",");
+    eosio_assert(pieces.size() >= 3, "Wrong memo parameter.");
+    eosio_assert(!pieces[1].empty(), "Roll type cannot be empty!");
+    eosio_assert(!pieces[2].empty(), "Roll prediction cannot be empty!");
+
+    uint8_t roll_type = atoi(pieces[1].c_str());
+    uint16_t roll_border = atoi(pieces[2].c_str());
+    eosio::name inviter;
+    if(pieces.size() > 3 && !pieces[3].empty())
+    {
+        inviter = eosio::name(pieces[3]);
+    }
+    return dice::memo::BetMemo{roll_type, roll_border, inviter, 1};
+}
+
+struct Result
+{
+    double ns_per_parse;
+    double allocations_per_parse;
+    uint64_t checksum;
+};
+
+template<class Parse>
+Result run(const std::vector<std::string>& memos, uint64_t iterations, Parse&& parse)
+{
+    uint64_t checksum = 0;
+    auto allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i < iterations; ++i)
+    {
+        for(const auto& memo: memos)
+        {
+            auto bet = parse(memo);
+            checksum += bet.roll_type + bet.roll_border + bet.inviter.value;
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double parses = double(iterations) * memos.size();
+    return Result{elapsed * 1e9 / parses, (allocations - allocations_before) / parses, checksum};
+}
+
+}//namespace
+
+int main(int argc, char** argv)
+{
+    uint64_t iterations = 1000000;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg.compare(0, 11, "iterations=") != 0)
+        {
+            std::fprintf(stderr, "wrong argument %s\n", argv[i]);
+            return 1;
+        }
+        iterations = std::max(1ull, std::strtoull(arg.c_str() + 11, nullptr, 10));
+    }
+
+    // memos accepted by both parsers with the same result
+    const std::vector<std::string> memos{
+        "bet,1,50",
+        "bet,2,3",
+        "bet,1,96,eosnowbetref",
+        "bet,2,75,player.one",
+    };
+    for(const auto& memo: memos)
+    {
+        auto a = dice::memo::parse_bet(memo);
+        auto b = parse_split(memo);
+        if(a.roll_type != b.roll_type || a.roll_border != b.roll_border || a.inviter != b.inviter)
+        {
+            std::fprintf(stderr, "parsers differ on %s\n", memo.c_str());
+            return 2;
+        }
+    }
+
+    auto memo = run(memos, iterations, [](const std::string& memo) { return dice::memo::parse_bet(memo); });
+    auto split = run(memos, iterations, [](const std::string& memo) { return parse_split(memo); });
+    if(memo.checksum != split.checksum)
+    {
+        std::fprintf(stderr, "checksums differ\n");
+        return 2;
+    }
+    std::printf("%-12s %12s %16s\n", "parser", "ns/parse", "allocs/parse");
+    std::printf("%-12s %12.1f %16.2f\n", "parse_bet", memo.ns_per_parse, memo.allocations_per_parse);
+    std::printf("%-12s %12.1f %16.2f\n", "split+atoi", split.ns_per_parse, split.allocations_per_parse);
+    std::printf("speedup %.2fx\n", split.ns_per_parse / memo.ns_per_parse);
+    return 0;
+}
@@ -0,0 +1,1629 @@
+#pragma once
+/*
+ * In-memory chain for native builds of contracts.
+ *
+ * Implements the intrinsics declared in eosiolib/intrinsics.h with the semantics of nodeos:
+ *     db_* tables and secondary indexes with per action iterator caches and RAM billing of payers,
+ *     authorization checks, notifications, inline actions, deferred transactions with delays and onerror,
+ *     tapos and read_transaction of the current transaction, sha256, console.
+ * Failed transactions are rolled back with an undo journal, eosio_assert throws assertion_failure.
+ * Every intrinsic call is counted, see Counters, with profiling enabled counters and wall time are also
+ * collected per action handler.
+ *
+ * Include this header in exactly one translation unit of a native build.
+ * */
+#include <eosiolib/transaction.hpp>
+#include "../sha256.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace eosio {
+namespace native {
+
+class assertion_failure: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/*
+ * intrinsic call counters, fields are listed by for_each_counter in output order
+ * */
+struct Counters
+{
+    uint64_t actions = 0;           // contract actions and notifications applied
+    uint64_t db_find = 0;           // db_find_i64, db_lowerbound_i64, db_upperbound_i64, db_end_i64
+    uint64_t db_next = 0;           // db_next_i64, db_previous_i64
+    uint64_t db_get = 0;            // rows read by db_get_i64
+    uint64_t db_store = 0;          // db_store_i64
+    uint64_t db_update = 0;         // db_update_i64
+    uint64_t db_remove = 0;         // db_remove_i64
+    uint64_t idx_find = 0;          // secondary find_primary, find_secondary, lowerbound, upperbound, end
+    uint64_t idx_next = 0;          // secondary next, previous
+    uint64_t idx_store = 0;         // secondary store
+    uint64_t idx_update = 0;        // secondary update
+    uint64_t idx_remove = 0;        // secondary remove
+    uint64_t sha256 = 0;            // sha256 and assert_sha256 calls
+    uint64_t sha256_bytes = 0;      // bytes hashed
+    uint64_t bytes_read = 0;        // row bytes read by db_get_i64
+    uint64_t bytes_written = 0;     // row bytes passed to db_store_i64 and db_update_i64
+    uint64_t inline_actions = 0;    // send_inline
+    uint64_t deferred = 0;          // send_deferred
+    uint64_t bytes_sent = 0;        // packed inline actions and deferred transactions
+
+    Counters& operator+=(const Counters& other)
+    {
+        for_each_counter([&](const char*, uint64_t Counters::* field)
+        {
+            this->*field += other.*field;
+        });
+        return *this;
+    }
+
+    Counters operator-(const Counters& other) const
+    {
+        Counters result = *this;
+        for_each_counter([&](const char*, uint64_t Counters::* field)
+        {
+            result.*field -= other.*field;
+        });
+        return result;
+    }
+
+    template<class F>
+    static void for_each_counter(F&& f)
+    {
+        f("actions", &Counters::actions);
+        f("db_find", &Counters::db_find);
+        f("db_next", &Counters::db_next);
+        f("db_get", &Counters::db_get);
+        f("db_store", &Counters::db_store);
+        f("db_update", &Counters::db_update);
+        f("db_remove", &Counters::db_remove);
+        f("idx_find", &Counters::idx_find);
+        f("idx_next", &Counters::idx_next);
+        f("idx_store", &Counters::idx_store);
+        f("idx_update", &Counters::idx_update);
+        f("idx_remove", &Counters::idx_remove);
+        f("sha256", &Counters::sha256);
+        f("sha256_bytes", &Counters::sha256_bytes);
+        f("bytes_read", &Counters::bytes_read);
+        f("bytes_written", &Counters::bytes_written);
+        f("inline", &Counters::inline_actions);
+        f("deferred", &Counters::deferred);
+        f("bytes_sent", &Counters::bytes_sent);
+    }
+};
+
+class Chain
+{
+public:
+    // billable overhead of one row, the same for primary and secondary rows
+    static constexpr int64_t row_overhead = 112;
+    static constexpr uint32_t max_inline_depth = 4;
+
+    // apply(receiver, code, action) of native contract
+    typedef std::function<void(uint64_t, uint64_t, uint64_t)> Apply;
+
+    struct Result
+    {
+        bool ok;
+        std::string error;
+    };
+
+    // counters and wall time of one action handler, collected when profiling is enabled
+    struct ActionStats
+    {
+        uint64_t calls = 0;
+        Counters counters;
+        double seconds = 0;
+    };
+
+    // receiver, code and name of action
+    typedef std::tuple<uint64_t, uint64_t, uint64_t> ActionKey;
+
+    static Chain& instance()
+    {
+        static Chain chain;
+        return chain;
+    }
+
+    /*
+     * accounts and contracts
+     * */
+    void create_account(name account)
+    {
+        _accounts.insert(account.value);
+    }
+
+    void set_contract(name account, Apply apply)
+    {
+        create_account(account);
+        _contracts[account.value] = std::move(apply);
+    }
+
+    // account which accepts every action and only counts them
+    void set_sink(name account)
+    {
+        set_contract(account, [this](uint64_t receiver, uint64_t code, uint64_t action)
+        {
+            if(receiver == code)
+            {
+                ++_sink_actions[{receiver, action}];
+            }
+        });
+    }
+
+    uint64_t sink_actions(name account, name action) const
+    {
+        auto it = _sink_actions.find({account.value, action.value});
+        return it == _sink_actions.end() ? 0 : it->second;
+    }
+
+    /*
+     * eosio.token model: balances of any symbol, transfer notifies sender and recipient
+     * */
+    void set_token(name account)
+    {
+        _token = account.value;
+        set_contract(account, [this](uint64_t receiver, uint64_t code, uint64_t action)
+        {
+            if(receiver == code && action == "transfer"_n.value)
+            {
+                token_transfer();
+            }
+        });
+    }
+
+    void issue(name to, const asset& quantity)
+    {
+        _balances[{to.value, quantity.symbol.raw()}] += quantity.amount;
+    }
+
+    asset balance(name account, symbol sym) const
+    {
+        auto it = _balances.find({account.value, sym.raw()});
+        return asset(it == _balances.end() ? 0 : it->second, sym);
+    }
+
+    /*
+     * time, blocks are produced every second
+     * */
+    uint32_t head_time() const
+    {
+        return _now;
+    }
+
+    void set_time(uint32_t seconds)
+    {
+        _now = seconds;
+    }
+
+    // moves time forward and runs deferred transactions which became due, returns amount of them
+    size_t produce(uint32_t seconds = 1)
+    {
+        size_t executed = 0;
+        for(uint32_t i = 0; i < seconds; ++i)
+        {
+            ++_now;
+            ++_head_block;
+            executed += run_deferred();
+        }
+        return executed;
+    }
+
+    size_t pending_deferred() const
+    {
+        return _deferred.size();
+    }
+
+    /*
+     * input transactions, every one gets unique bytes so transaction hashes differ
+     * */
+    Result push_action(name account, name action_name, std::vector<permission_level> auths, std::vector<char> data)
+    {
+        action act;
+        act.account = account;
+        act.name = action_name;
+        act.authorization = std::move(auths);
+        act.data = std::move(data);
+        return push_transaction({act});
+    }
+
+    template<typename... Args>
+    Result push(name signer, name account, name action_name, Args&&... args)
+    {
+        return push_action(account, action_name, {permission_level{signer, "active"_n}},
+                pack(std::make_tuple(std::forward<Args>(args)...)));
+    }
+
+    Result push_transaction(std::vector<action> actions)
+    {
+        transaction trx(time_point_sec(_now + 60));
+        trx.ref_block_num = uint16_t(_head_block);
+        trx.ref_block_prefix = block_prefix(_head_block);
+        // eosio.null::nonce, the usual way to make equal transactions unique
+        action nonce;
+        nonce.account = "eosio.null"_n;
+        nonce.name = "nonce"_n;
+        nonce.data = pack(++_nonce);
+        trx.context_free_actions.push_back(nonce);
+        trx.actions = std::move(actions);
+        return execute(trx, 0, 0);
+    }
+
+    /*
+     * counters and console
+     * */
+    const Counters& counters() const
+    {
+        return _counters;
+    }
+
+    void reset_counters()
+    {
+        _counters = Counters();
+    }
+
+    // console of last transaction, printed to stderr when echo is enabled
+    const std::string& console() const
+    {
+        return _console;
+    }
+
+    void set_console_echo(bool echo)
+    {
+        _echo = echo;
+    }
+
+    void set_profiling(bool enabled)
+    {
+        _profiling = enabled;
+    }
+
+    const std::map<ActionKey, ActionStats>& action_stats() const
+    {
+        return _action_stats;
+    }
+
+    void reset_action_stats()
+    {
+        _action_stats.clear();
+    }
+
+    int64_t ram_usage(name account) const
+    {
+        auto it = _ram.find(account.value);
+        return it == _ram.end() ? 0 : it->second;
+    }
+
+    /*
+     * runs f with read only access to tables of code, ie to inspect them with multi_index
+     * */
+    template<class F>
+    void read(name code, F&& f)
+    {
+        Context ctx;
+        ctx.receiver = code.value;
+        ctx.read_only = true;
+        auto* previous = _context;
+        _context = &ctx;
+        try
+        {
+            f();
+        }
+        catch(...)
+        {
+            _context = previous;
+            throw;
+        }
+        _context = previous;
+    }
+
+    /*
+     * intrinsics
+     * */
+    [[noreturn]] void fail(const char* msg)
+    {
+        throw assertion_failure(msg);
+    }
+
+    void check(bool test, const char* msg)
+    {
+        if(!test)
+        {
+            fail(msg);
+        }
+    }
+
+    uint64_t current_time_us() const
+    {
+        return uint64_t(_now) * 1000000;
+    }
+
+    uint32_t read_action_data(void* msg, uint32_t len)
+    {
+        auto& data = context().act->data;
+        auto size = std::min<size_t>(len, data.size());
+        if(size > 0)
+        {
+            std::memcpy(msg, data.data(), size);
+        }
+        return uint32_t(size);
+    }
+
+    uint32_t action_data_size()
+    {
+        return uint32_t(context().act->data.size());
+    }
+
+    void require_recipient(uint64_t account)
+    {
+        auto& ctx = context();
+        check(_accounts.count(account) > 0, "can only notify existing accounts");
+        if(std::find(ctx.recipients->begin(), ctx.recipients->end(), account) == ctx.recipients->end())
+        {
+            ctx.recipients->push_back(account);
+        }
+    }
+
+    bool has_auth(uint64_t account)
+    {
+        auto& auths = context().act->authorization;
+        return std::any_of(auths.begin(), auths.end(), [&](const permission_level& p)
+        {
+            return p.actor.value == account;
+        });
+    }
+
+    void require_auth(uint64_t account)
+    {
+        if(!has_auth(account))
+        {
+            std::string msg = "missing authority of " + name(account).to_string();
+            fail(msg.c_str());
+        }
+    }
+
+    bool is_account(uint64_t account) const
+    {
+        return _accounts.count(account) > 0;
+    }
+
+    uint64_t current_receiver()
+    {
+        return context().receiver;
+    }
+
+    void send_inline(const char* data, size_t size)
+    {
+        auto& ctx = context();
+        check(!ctx.read_only, "send_inline in read only context");
+        auto act = unpack<action>(data, size);
+        for(auto& auth: act.authorization)
+        {
+            check(auth.actor.value == ctx.receiver, "inline action must be authorized by sending contract");
+        }
+        ctx.inlines->push_back(std::move(act));
+        ++_counters.inline_actions;
+        _counters.bytes_sent += size;
+    }
+
+    void send_deferred(const uint128_t& sender_id, uint64_t payer, const char* data, size_t size, bool replace)
+    {
+        auto& ctx = context();
+        check(!ctx.read_only, "send_deferred in read only context");
+        check(payer == ctx.receiver || has_auth(payer), "deferred transaction payer must authorize the action");
+        auto trx = unpack<transaction>(data, size);
+        for(auto& act: trx.actions)
+        {
+            for(auto& auth: act.authorization)
+            {
+                check(auth.actor.value == ctx.receiver, "deferred transaction must be authorized by sending contract");
+            }
+        }
+        auto key = std::make_pair(ctx.receiver, sender_id);
+        auto it = _deferred.find(key);
+        if(it != _deferred.end())
+        {
+            check(replace, "deferred transaction with the same sender_id and payer already exists");
+            auto previous = it->second;
+            journal([this, key, previous]() { _deferred[key] = previous; });
+            _deferred.erase(it);
+        }
+        else
+        {
+            journal([this, key]() { _deferred.erase(key); });
+        }
+        Deferred deferred{ctx.receiver, sender_id, _now + trx.delay_sec.value, ++_deferred_sequence,
+                std::vector<char>(data, data + size)};
+        _deferred.emplace(key, std::move(deferred));
+        ++_counters.deferred;
+        _counters.bytes_sent += size;
+    }
+
+    int cancel_deferred(const uint128_t& sender_id)
+    {
+        auto key = std::make_pair(context().receiver, sender_id);
+        auto it = _deferred.find(key);
+        if(it == _deferred.end())
+        {
+            return 0;
+        }
+        auto previous = it->second;
+        journal([this, key, previous]() { _deferred[key] = previous; });
+        _deferred.erase(it);
+        return 1;
+    }
+
+    size_t transaction_size() const
+    {
+        return _transaction.size();
+    }
+
+    int read_transaction(char* buffer, size_t size) const
+    {
+        if(size == 0)
+        {
+            return int(_transaction.size());
+        }
+        auto copied = std::min(size, _transaction.size());
+        std::memcpy(buffer, _transaction.data(), copied);
+        return int(copied);
+    }
+
+    int tapos_block_num() const
+    {
+        return _tapos_block_num;
+    }
+
+    int tapos_block_prefix() const
+    {
+        return _tapos_block_prefix;
+    }
+
+    uint32_t expiration() const
+    {
+        return _expiration;
+    }
+
+    void sha256(const char* data, uint32_t length, capi_checksum256* hash)
+    {
+        ++_counters.sha256;
+        _counters.sha256_bytes += length;
+        dice::sha256::detail::hash_one(_kernel, reinterpret_cast<const uint8_t*>(data), length, hash->hash,
+                _sha256_buffer);
+    }
+
+    void print(const char* data, size_t size)
+    {
+        _console.append(data, size);
+        if(_echo)
+        {
+            fwrite(data, 1, size, stderr);
+        }
+    }
+
+    /*
+     * primary index
+     * */
+    int32_t db_store_i64(uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len)
+    {
+        auto& ctx = writable_context();
+        ++_counters.db_store;
+        _counters.bytes_written += len;
+        check(is_account(payer), "must specify a valid account to pay for new record");
+        auto& t = _tables[TableKey{ctx.receiver, scope, table}];
+        check(t.rows.count(id) == 0, "could not insert object, most likely a uniqueness constraint was violated");
+        auto* ptr = &t;
+        t.rows.emplace(id, Row{std::vector<char>((const char*)data, (const char*)data + len), payer});
+        journal([ptr, id]() { ptr->rows.erase(id); });
+        charge(payer, len + row_overhead);
+        return ctx.primary.add(ptr, id);
+    }
+
+    void db_update_i64(int32_t iterator, uint64_t payer, const void* data, uint32_t len)
+    {
+        auto& ctx = writable_context();
+        ++_counters.db_update;
+        _counters.bytes_written += len;
+        auto* t = ctx.primary.table(iterator);
+        check(t->key.code == ctx.receiver, "db access violation");
+        auto pk = ctx.primary.primary_key(iterator);
+        auto& row = t->rows.at(pk);
+        auto previous = row;
+        if(0 == payer)
+        {
+            payer = row.payer;
+        }
+        check(is_account(payer), "must specify a valid account to pay for new record");
+        // as in nodeos, the same payer is charged only for the size difference
+        if(payer == row.payer)
+        {
+            charge(payer, int64_t(len) - int64_t(row.value.size()));
+        }
+        else
+        {
+            charge(row.payer, -int64_t(row.value.size()) - row_overhead);
+            charge(payer, len + row_overhead);
+        }
+        row.value.assign((const char*)data, (const char*)data + len);
+        row.payer = payer;
+        journal([t, pk, previous]() { t->rows[pk] = previous; });
+    }
+
+    void db_remove_i64(int32_t iterator)
+    {
+        auto& ctx = writable_context();
+        ++_counters.db_remove;
+        auto* t = ctx.primary.table(iterator);
+        check(t->key.code == ctx.receiver, "db access violation");
+        auto pk = ctx.primary.primary_key(iterator);
+        auto it = t->rows.find(pk);
+        auto previous = it->second;
+        charge(previous.payer, -int64_t(previous.value.size()) - row_overhead);
+        t->rows.erase(it);
+        journal([t, pk, previous]() { t->rows[pk] = previous; });
+        ctx.primary.remove(iterator);
+    }
+
+    int32_t db_get_i64(int32_t iterator, void* data, uint32_t len)
+    {
+        auto& ctx = context();
+        auto* t = ctx.primary.table(iterator);
+        auto& row = t->rows.at(ctx.primary.primary_key(iterator));
+        if(0 == len)
+        {
+            return int32_t(row.value.size());
+        }
+        ++_counters.db_get;
+        auto copied = std::min<size_t>(len, row.value.size());
+        _counters.bytes_read += copied;
+        std::memcpy(data, row.value.data(), copied);
+        return int32_t(row.value.size());
+    }
+
+    int32_t db_next_i64(int32_t iterator, uint64_t* primary)
+    {
+        auto& ctx = context();
+        ++_counters.db_next;
+        if(iterator < -1)
+        {
+            return -1;
+        }
+        auto* t = ctx.primary.table(iterator);
+        auto it = t->rows.upper_bound(ctx.primary.primary_key(iterator));
+        if(it == t->rows.end())
+        {
+            return ctx.primary.end_iterator(t);
+        }
+        *primary = it->first;
+        return ctx.primary.add(t, it->first);
+    }
+
+    int32_t db_previous_i64(int32_t iterator, uint64_t* primary)
+    {
+        auto& ctx = context();
+        ++_counters.db_next;
+        if(iterator < -1)
+        {
+            auto* t = ctx.primary.table_of_end(iterator);
+            if(t->rows.empty())
+            {
+                return -1;
+            }
+            auto it = std::prev(t->rows.end());
+            *primary = it->first;
+            return ctx.primary.add(t, it->first);
+        }
+        auto* t = ctx.primary.table(iterator);
+        auto it = t->rows.find(ctx.primary.primary_key(iterator));
+        if(it == t->rows.begin())
+        {
+            return -1;
+        }
+        --it;
+        *primary = it->first;
+        return ctx.primary.add(t, it->first);
+    }
+
+    int32_t db_find_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id)
+    {
+        auto& ctx = context();
+        ++_counters.db_find;
+        auto* t = find_table(_tables, code, scope, table);
+        if(!t)
+        {
+            return -1;
+        }
+        if(t->rows.count(id) == 0)
+        {
+            return ctx.primary.end_iterator(t);
+        }
+        return ctx.primary.add(t, id);
+    }
+
+    int32_t db_lowerbound_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id)
+    {
+        auto& ctx = context();
+        ++_counters.db_find;
+        auto* t = find_table(_tables, code, scope, table);
+        if(!t)
+        {
+            return -1;
+        }
+        auto it = t->rows.lower_bound(id);
+        if(it == t->rows.end())
+        {
+            return ctx.primary.end_iterator(t);
+        }
+        return ctx.primary.add(t, it->first);
+    }
+
+    int32_t db_upperbound_i64(uint64_t code, uint64_t scope, uint64_t table, uint64_t id)
+    {
+        auto& ctx = context();
+        ++_counters.db_find;
+        auto* t = find_table(_tables, code, scope, table);
+        if(!t)
+        {
+            return -1;
+        }
+        auto it = t->rows.upper_bound(id);
+        if(it == t->rows.end())
+        {
+            return ctx.primary.end_iterator(t);
+        }
+        return ctx.primary.add(t, it->first);
+    }
+
+    int32_t db_end_i64(uint64_t code, uint64_t scope, uint64_t table)
+    {
+        auto& ctx = context();
+        ++_counters.db_find;
+        auto* t = find_table(_tables, code, scope, table);
+        if(!t)
+        {
+            return -1;
+        }
+        return ctx.primary.end_iterator(t);
+    }
+
+    /*
+     * secondary indexes, keys of all types are stored as uint128_t,
+     * kind separates indexes of different key types with the same table name
+     * */
+    enum IndexKind: uint8_t
+    {
+        IDX64 = 0,
+        IDX128 = 1
+    };
+
+    int32_t idx_store(IndexKind kind, uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, uint128_t key)
+    {
+        auto& ctx = writable_context();
+        ++_counters.idx_store;
+        check(is_account(payer), "must specify a valid account to pay for new record");
+        auto& index = _indexes[kind][TableKey{ctx.receiver, scope, table}];
+        check(index.rows.count(id) == 0, "secondary key already exists for primary key");
+        auto* ptr = &index;
+        index.rows.emplace(id, SecondaryRow{key, payer});
+        index.keys.emplace(key, id);
+        journal([ptr, id, key]()
+        {
+            ptr->rows.erase(id);
+            ptr->keys.erase({key, id});
+        });
+        charge(payer, row_overhead);
+        return ctx.secondary[kind].add(ptr, id);
+    }
+
+    void idx_update(IndexKind kind, int32_t iterator, uint64_t payer, uint128_t key)
+    {
+        auto& ctx = writable_context();
+        ++_counters.idx_update;
+        auto* index = ctx.secondary[kind].table(iterator);
+        check(index->key.code == ctx.receiver, "db access violation");
+        auto pk = ctx.secondary[kind].primary_key(iterator);
+        auto& row = index->rows.at(pk);
+        auto previous = row;
+        if(0 == payer)
+        {
+            payer = row.payer;
+        }
+        if(payer != row.payer)
+        {
+            charge(row.payer, -row_overhead);
+            charge(payer, row_overhead);
+        }
+        index->keys.erase({row.key, pk});
+        index->keys.emplace(key, pk);
+        row = SecondaryRow{key, payer};
+        journal([index, pk, previous, key]()
+        {
+            index->keys.erase({key, pk});
+            index->keys.emplace(previous.key, pk);
+            index->rows[pk] = previous;
+        });
+    }
+
+    void idx_remove(IndexKind kind, int32_t iterator)
+    {
+        auto& ctx = writable_context();
+        ++_counters.idx_remove;
+        auto* index = ctx.secondary[kind].table(iterator);
+        check(index->key.code == ctx.receiver, "db access violation");
+        auto pk = ctx.secondary[kind].primary_key(iterator);
+        auto previous = index->rows.at(pk);
+        charge(previous.payer, -row_overhead);
+        index->keys.erase({previous.key, pk});
+        index->rows.erase(pk);
+        journal([index, pk, previous]()
+        {
+            index->keys.emplace(previous.key, pk);
+            index->rows[pk] = previous;
+        });
+        ctx.secondary[kind].remove(iterator);
+    }
+
+    int32_t idx_next(IndexKind kind, int32_t iterator, uint64_t* primary)
+    {
+        auto& ctx = context();
+        ++_counters.idx_next;
+        if(iterator < -1)
+        {
+            return -1;
+        }
+        auto& cache = ctx.secondary[kind];
+        auto* index = cache.table(iterator);
+        auto pk = cache.primary_key(iterator);
+        auto it = index->keys.upper_bound({index->rows.at(pk).key, pk});
+        if(it == index->keys.end())
+        {
+            return cache.end_iterator(index);
+        }
+        *primary = it->second;
+        return cache.add(index, it->second);
+    }
+
+    int32_t idx_previous(IndexKind kind, int32_t iterator, uint64_t* primary)
+    {
+        auto& ctx = context();
+        ++_counters.idx_next;
+        auto& cache = ctx.secondary[kind];
+        if(iterator < -1)
+        {
+            auto* index = cache.table_of_end(iterator);
+            if(index->keys.empty())
+            {
+                return -1;
+            }
+            auto it = std::prev(index->keys.end());
+            *primary = it->second;
+            return cache.add(index, it->second);
+        }
+        auto* index = cache.table(iterator);
+        auto pk = cache.primary_key(iterator);
+        auto it = index->keys.find({index->rows.at(pk).key, pk});
+        if(it == index->keys.begin())
+        {
+            return -1;
+        }
+        --it;
+        *primary = it->second;
+        return cache.add(index, it->second);
+    }
+
+    int32_t idx_find_primary(IndexKind kind, uint64_t code, uint64_t scope, uint64_t table, uint128_t& key,
+            uint64_t primary)
+    {
+        auto& ctx = context();
+        ++_counters.idx_find;
+        auto* index = find_table(_indexes[kind], code, scope, table);
+        if(!index)
+        {
+            return -1;
+        }
+        auto it = index->rows.find(primary);
+        if(it == index->rows.end())
+        {
+            return ctx.secondary[kind].end_iterator(index);
+        }
+        key = it->second.key;
+        return ctx.secondary[kind].add(index, primary);
+    }
+
+    int32_t idx_find_secondary(IndexKind kind, uint64_t code, uint64_t scope, uint64_t table, uint128_t key,
+            uint64_t& primary)
+    {
+        auto& ctx = context();
+        ++_counters.idx_find;
+        auto* index = find_table(_indexes[kind], code, scope, table);
+        if(!index)
+        {
+            return -1;
+        }
+        auto it = index->keys.lower_bound({key, 0});
+        if(it == index->keys.end() || it->first != key)
+        {
+            return ctx.secondary[kind].end_iterator(index);
+        }
+        primary = it->second;
+        return ctx.secondary[kind].add(index, it->second);
+    }
+
+    int32_t idx_bound(IndexKind kind, uint64_t code, uint64_t scope, uint64_t table, uint128_t& key,
+            uint64_t& primary, bool upper)
+    {
+        auto& ctx = context();
+        ++_counters.idx_find;
+        auto* index = find_table(_indexes[kind], code, scope, table);
+        if(!index)
+        {
+            return -1;
+        }
+        auto it = upper ? index->keys.upper_bound({key, std::numeric_limits<uint64_t>::max()})
+                        : index->keys.lower_bound({key, 0});
+        if(it == index->keys.end())
+        {
+            return ctx.secondary[kind].end_iterator(index);
+        }
+        key = it->first;
+        primary = it->second;
+        return ctx.secondary[kind].add(index, it->second);
+    }
+
+    int32_t idx_end(IndexKind kind, uint64_t code, uint64_t scope, uint64_t table)
+    {
+        auto& ctx = context();
+        ++_counters.idx_find;
+        auto* index = find_table(_indexes[kind], code, scope, table);
+        if(!index)
+        {
+            return -1;
+        }
+        return ctx.secondary[kind].end_iterator(index);
+    }
+
+private:
+    struct TableKey
+    {
+        uint64_t code;
+        uint64_t scope;
+        uint64_t table;
+
+        bool operator<(const TableKey& other) const
+        {
+            return std::tie(code, scope, table) < std::tie(other.code, other.scope, other.table);
+        }
+    };
+
+    struct Row
+    {
+        std::vector<char> value;
+        uint64_t payer;
+    };
+
+    struct Table
+    {
+        TableKey key;
+        std::map<uint64_t, Row> rows;
+    };
+
+    struct SecondaryRow
+    {
+        uint128_t key;
+        uint64_t payer;
+    };
+
+    struct Index
+    {
+        TableKey key;
+        std::map<uint64_t, SecondaryRow> rows;
+        std::set<std::pair<uint128_t, uint64_t>> keys;
+    };
+
+    // table maps which set key of new tables
+    template<class T>
+    struct Tables: public std::map<TableKey, T>
+    {
+        T& operator[](const TableKey& key)
+        {
+            auto it = this->find(key);
+            if(it == this->end())
+            {
+                it = this->emplace(key, T()).first;
+                it->second.key = key;
+            }
+            return it->second;
+        }
+    };
+
+    /*
+     * iterators of one action: non negative values are rows, end iterators of tables are -2, -3, ...
+     * */
+    template<class T>
+    class IteratorCache
+    {
+    public:
+        int32_t end_iterator(T* table)
+        {
+            auto it = _end_index.find(table);
+            if(it != _end_index.end())
+            {
+                return it->second;
+            }
+            _ends.push_back(table);
+            int32_t result = -int32_t(_ends.size()) - 1;
+            _end_index.emplace(table, result);
+            return result;
+        }
+
+        T* table_of_end(int32_t iterator)
+        {
+            size_t index = size_t(-iterator - 2);
+            Chain::instance().check(index < _ends.size(), "invalid end iterator");
+            return _ends[index];
+        }
+
+        int32_t add(T* table, uint64_t primary)
+        {
+            end_iterator(table);
+            auto key = std::make_pair(table, primary);
+            auto it = _object_index.find(key);
+            if(it != _object_index.end())
+            {
+                return it->second;
+            }
+            int32_t result = int32_t(_objects.size());
+            _objects.push_back(key);
+            _object_index.emplace(key, result);
+            return result;
+        }
+
+        T* table(int32_t iterator)
+        {
+            Chain::instance().check(iterator >= 0 && size_t(iterator) < _objects.size(), "invalid iterator");
+            auto* result = _objects[iterator].first;
+            Chain::instance().check(result != nullptr, "dereference of deleted object");
+            return result;
+        }
+
+        uint64_t primary_key(int32_t iterator)
+        {
+            table(iterator);
+            return _objects[iterator].second;
+        }
+
+        void remove(int32_t iterator)
+        {
+            _object_index.erase(_objects[iterator]);
+            _objects[iterator].first = nullptr;
+        }
+
+    private:
+        std::vector<T*> _ends;
+        std::map<T*, int32_t> _end_index;
+        std::vector<std::pair<T*, uint64_t>> _objects;
+        std::map<std::pair<T*, uint64_t>, int32_t> _object_index;
+    };
+
+    struct Context
+    {
+        uint64_t receiver = 0;
+        const action* act = nullptr;
+        bool notify = false;
+        bool read_only = false;
+        std::vector<uint64_t>* recipients = nullptr;
+        std::vector<action>* inlines = nullptr;
+        IteratorCache<Table> primary;
+        IteratorCache<Index> secondary[2];
+    };
+
+    struct Deferred
+    {
+        uint64_t sender;
+        uint128_t sender_id;
+        uint32_t delivery;
+        uint64_t sequence;
+        std::vector<char> packed;
+    };
+
+    Chain()
+    {
+        _kernel = dice::sha256::is_supported(dice::sha256::Kernel::SHANI) ? dice::sha256::Kernel::SHANI
+                                                                          : dice::sha256::Kernel::SCALAR;
+        create_account("eosio"_n);
+        create_account("eosio.null"_n);
+    }
+
+    Context& context()
+    {
+        check(_context != nullptr, "intrinsic is called outside of action");
+        return *_context;
+    }
+
+    Context& writable_context()
+    {
+        auto& ctx = context();
+        check(!ctx.read_only, "table is modified in read only context");
+        return ctx;
+    }
+
+    template<class M>
+    static typename M::mapped_type* find_table(M& tables, uint64_t code, uint64_t scope, uint64_t table)
+    {
+        auto it = tables.find(TableKey{code, scope, table});
+        return it == tables.end() ? nullptr : &it->second;
+    }
+
+    static uint32_t block_prefix(uint64_t block)
+    {
+        // any value which changes with block, real prefix is a part of block id
+        return uint32_t((block + 1) * 0x9E3779B97F4A7C15ull >> 32);
+    }
+
+    void journal(std::function<void()> undo)
+    {
+        if(_in_transaction)
+        {
+            _journal.push_back(std::move(undo));
+        }
+    }
+
+    /*
+     * RAM of payer, other accounts can be billed only when they authorized the action and not in notifications
+     * */
+    void charge(uint64_t payer, int64_t delta)
+    {
+        auto& ctx = context();
+        if(delta > 0 && payer != ctx.receiver)
+        {
+            check(!ctx.notify, "cannot charge RAM to other accounts during notify");
+            check(has_auth(payer),
+                    "unprivileged contract cannot increase RAM usage of another account that has not authorized the action");
+        }
+        _ram[payer] += delta;
+        journal([this, payer, delta]() { _ram[payer] -= delta; });
+    }
+
+    void token_transfer()
+    {
+        auto data = unpack_action_data<std::tuple<name, name, asset, std::string>>();
+        auto& from = std::get<0>(data);
+        auto& to = std::get<1>(data);
+        auto& quantity = std::get<2>(data);
+        check(from != to, "cannot transfer to self");
+        require_auth(from.value);
+        check(is_account(to.value), "to account does not exist");
+        check(quantity.is_valid(), "invalid quantity");
+        check(quantity.amount > 0, "must transfer positive quantity");
+        check(std::get<3>(data).size() <= 256, "memo has more than 256 bytes");
+        require_recipient(from.value);
+        require_recipient(to.value);
+        add_balance(from, -quantity.amount, quantity.symbol);
+        add_balance(to, quantity.amount, quantity.symbol);
+    }
+
+    void add_balance(name owner, int64_t amount, symbol sym)
+    {
+        auto key = std::make_pair(owner.value, sym.raw());
+        auto& balance = _balances[key];
+        check(balance + amount >= 0, "overdrawn balance");
+        balance += amount;
+        journal([this, key, amount]() { _balances[key] -= amount; });
+    }
+
+    /*
+     * executes all actions of transaction, changes are rolled back when one of them fails
+     * */
+    Result execute(const transaction& trx, uint64_t onerror_sender, const uint128_t& sender_id)
+    {
+        auto packed = pack(trx);
+        _transaction = packed;
+        _tapos_block_num = trx.ref_block_num;
+        _tapos_block_prefix = trx.ref_block_prefix;
+        _expiration = trx.expiration.sec_since_epoch();
+        _console.clear();
+        _journal.clear();
+        _in_transaction = true;
+        Result result{true, ""};
+        try
+        {
+            for(auto& act: trx.actions)
+            {
+                apply_action(act, act.account.value, 0);
+            }
+        }
+        catch(const std::exception& e)
+        {
+            result = Result{false, e.what()};
+        }
+        _context = nullptr;
+        if(!result.ok)
+        {
+            for(auto it = _journal.rbegin(); it != _journal.rend(); ++it)
+            {
+                (*it)();
+            }
+        }
+        _journal.clear();
+        _in_transaction = false;
+        if(!result.ok && onerror_sender != 0)
+        {
+            deliver_onerror(onerror_sender, sender_id, packed);
+        }
+        return result;
+    }
+
+    /*
+     * applies action to its receiver, then to notified accounts, then inline actions sent by all of them
+     * */
+    void apply_action(const action& act, uint64_t receiver, uint32_t depth)
+    {
+        check(depth <= max_inline_depth, "max inline action depth per transaction reached");
+        std::vector<uint64_t> recipients{receiver};
+        std::vector<action> inlines;
+        for(size_t i = 0; i < recipients.size(); ++i)
+        {
+            auto contract = _contracts.find(recipients[i]);
+            if(contract == _contracts.end())
+            {
+                check(is_account(recipients[i]), "action's receiver account does not exist");
+                continue;
+            }
+            Context ctx;
+            ctx.receiver = recipients[i];
+            ctx.act = &act;
+            ctx.notify = i > 0;
+            ctx.recipients = &recipients;
+            ctx.inlines = &inlines;
+            _context = &ctx;
+            if(_profiling)
+            {
+                profile(ctx.receiver, act, contract->second);
+            }
+            else
+            {
+                ++_counters.actions;
+                contract->second(ctx.receiver, act.account.value, act.name.value);
+            }
+            _context = nullptr;
+        }
+        for(auto& inline_action: inlines)
+        {
+            apply_action(inline_action, inline_action.account.value, depth + 1);
+        }
+    }
+
+    // failed handlers are not recorded, their transaction is rolled back
+    void profile(uint64_t receiver, const action& act, const Apply& apply)
+    {
+        auto before = _counters;
+        auto start = std::chrono::steady_clock::now();
+        ++_counters.actions;
+        apply(receiver, act.account.value, act.name.value);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto& stats = _action_stats[ActionKey{receiver, act.account.value, act.name.value}];
+        ++stats.calls;
+        stats.counters += _counters - before;
+        stats.seconds += elapsed;
+    }
+
+    size_t run_deferred()
+    {
+        std::vector<std::pair<std::pair<uint64_t, uint128_t>, Deferred>> due;
+        for(auto& entry: _deferred)
+        {
+            if(entry.second.delivery <= _now)
+            {
+                due.push_back(entry);
+            }
+        }
+        std::sort(due.begin(), due.end(), [](const auto& a, const auto& b)
+        {
+            return a.second.sequence < b.second.sequence;
+        });
+        for(auto& entry: due)
+        {
+            _deferred.erase(entry.first);
+            auto trx = unpack<transaction>(entry.second.packed);
+            execute(trx, entry.second.sender, entry.second.sender_id);
+        }
+        return due.size();
+    }
+
+    // onerror is applied by sender with code eosio, its failure is ignored
+    void deliver_onerror(uint64_t sender, const uint128_t& sender_id, const std::vector<char>& packed)
+    {
+        action act;
+        act.account = "eosio"_n;
+        act.name = "onerror"_n;
+        act.authorization.push_back(permission_level{name(sender), "active"_n});
+        act.data = pack(onerror{sender_id, packed});
+        transaction trx(time_point_sec(_now + 60));
+        trx.actions.push_back(act);
+        _transaction = pack(trx);
+        _console.clear();
+        _journal.clear();
+        _in_transaction = true;
+        bool ok = true;
+        try
+        {
+            apply_action(act, sender, 0);
+        }
+        catch(const std::exception&)
+        {
+            ok = false;
+        }
+        _context = nullptr;
+        if(!ok)
+        {
+            for(auto it = _journal.rbegin(); it != _journal.rend(); ++it)
+            {
+                (*it)();
+            }
+        }
+        _journal.clear();
+        _in_transaction = false;
+    }
+
+    std::set<uint64_t> _accounts;
+    std::map<uint64_t, Apply> _contracts;
+    std::map<std::pair<uint64_t, uint64_t>, uint64_t> _sink_actions;
+    uint64_t _token = 0;
+    std::map<std::pair<uint64_t, uint64_t>, int64_t> _balances;
+
+    Tables<Table> _tables;
+    Tables<Index> _indexes[2];
+    std::map<uint64_t, int64_t> _ram;
+
+    std::map<std::pair<uint64_t, uint128_t>, Deferred> _deferred;
+    uint64_t _deferred_sequence = 0;
+
+    uint32_t _now = 1546300800;     // 2019-01-01
+    uint64_t _head_block = 1;
+    uint64_t _nonce = 0;
+
+    Context* _context = nullptr;
+    std::vector<char> _transaction;
+    int _tapos_block_num = 0;
+    int _tapos_block_prefix = 0;
+    uint32_t _expiration = 0;
+
+    bool _in_transaction = false;
+    std::vector<std::function<void()>> _journal;
+
+    Counters _counters;
+    bool _profiling = false;
+    std::map<ActionKey, ActionStats> _action_stats;
+    std::string _console;
+    bool _echo = false;
+
+    dice::sha256::Kernel _kernel;
+    std::vector<uint8_t> _sha256_buffer;
+};
+
+inline Chain& chain()
+{
+    return Chain::instance();
+}
+
+}//namespace native
+}//namespace eosio
+
+/*
+ * intrinsics
+ * */
+using eosio::native::chain;
+
+extern "C" {
+
+void eosio_assert(uint32_t test, const char* msg)
+{
+    if(!test)
+    {
+        chain().fail(msg);
+    }
+}
+
+void eosio_assert_code(uint32_t test, uint64_t code)
+{
+    if(!test)
+    {
+        chain().fail(("assertion failure with error code: " + std::to_string(code)).c_str());
+    }
+}
+
+uint64_t current_time()
+{
+    return chain().current_time_us();
+}
+
+uint32_t now()
+{
+    return uint32_t(current_time() / 1000000);
+}
+
+uint32_t read_action_data(void* msg, uint32_t len)
+{
+    return chain().read_action_data(msg, len);
+}
+
+uint32_t action_data_size()
+{
+    return chain().action_data_size();
+}
+
+void require_recipient(capi_name name)
+{
+    chain().require_recipient(name);
+}
+
+void require_auth(capi_name name)
+{
+    chain().require_auth(name);
+}
+
+void require_auth2(capi_name name, capi_name)
+{
+    chain().require_auth(name);
+}
+
+bool has_auth(capi_name name)
+{
+    return chain().has_auth(name);
+}
+
+bool is_account(capi_name name)
+{
+    return chain().is_account(name);
+}
+
+capi_name current_receiver()
+{
+    return chain().current_receiver();
+}
+
+void send_inline(char* serialized_action, size_t size)
+{
+    chain().send_inline(serialized_action, size);
+}
+
+void send_deferred(const uint128_t& sender_id, capi_name payer, const char* serialized_transaction, size_t size,
+        uint32_t replace_existing)
+{
+    chain().send_deferred(sender_id, payer, serialized_transaction, size, replace_existing != 0);
+}
+
+int cancel_deferred(const uint128_t& sender_id)
+{
+    return chain().cancel_deferred(sender_id);
+}
+
+size_t transaction_size()
+{
+    return chain().transaction_size();
+}
+
+int read_transaction(char* buffer, size_t size)
+{
+    return chain().read_transaction(buffer, size);
+}
+
+int tapos_block_num()
+{
+    return chain().tapos_block_num();
+}
+
+int tapos_block_prefix()
+{
+    return chain().tapos_block_prefix();
+}
+
+uint32_t expiration()
+{
+    return chain().expiration();
+}
+
+void sha256(const char* data, uint32_t length, capi_checksum256* hash)
+{
+    chain().sha256(data, length, hash);
+}
+
+void assert_sha256(const char* data, uint32_t length, const capi_checksum256* hash)
+{
+    capi_checksum256 result;
+    chain().sha256(data, length, &result);
+    eosio_assert(0 == std::memcmp(result.hash, hash->hash, sizeof(result.hash)), "hash mismatch");
+}
+
+void prints(const char* cstr)
+{
+    chain().print(cstr, std::strlen(cstr));
+}
+
+void prints_l(const char* cstr, uint32_t len)
+{
+    chain().print(cstr, len);
+}
+
+void printi(int64_t value)
+{
+    auto str = std::to_string(value);
+    chain().print(str.data(), str.size());
+}
+
+void printui(uint64_t value)
+{
+    auto str = std::to_string(value);
+    chain().print(str.data(), str.size());
+}
+
+void printi128(const int128_t* value)
+{
+    uint128_t magnitude = *value < 0 ? -uint128_t(*value) : uint128_t(*value);
+    if(*value < 0)
+    {
+        prints("-");
+    }
+    printui128(&magnitude);
+}
+
+void printui128(const uint128_t* value)
+{
+    char buffer[40];
+    char* p = buffer + sizeof(buffer);
+    *--p = '\0';
+    auto v = *value;
+    do
+    {
+        *--p = char('0' + int(v % 10));
+        v /= 10;
+    } while(v != 0);
+    prints(p);
+}
+
+void printdf(double value)
+{
+    char buffer[32];
+    auto size = snprintf(buffer, sizeof(buffer), "%.15e", value);
+    chain().print(buffer, size);
+}
+
+void printn(uint64_t name)
+{
+    auto str = eosio::name(name).to_string();
+    chain().print(str.data(), str.size());
+}
+
+void printhex(const void* data, uint32_t datalen)
+{
+    static const char digits[] = "0123456789abcdef";
+    auto bytes = static_cast<const uint8_t*>(data);
+    std::string str;
+    for(uint32_t i = 0; i < datalen; ++i)
+    {
+        str += digits[bytes[i] >> 4];
+        str += digits[bytes[i] & 0x0f];
+    }
+    chain().print(str.data(), str.size());
+}
+
+int32_t db_store_i64(uint64_t scope, capi_name table, capi_name payer, uint64_t id, const void* data, uint32_t len)
+{
+    return chain().db_store_i64(scope, table, payer, id, data, len);
+}
+
+void db_update_i64(int32_t iterator, capi_name payer, const void* data, uint32_t len)
+{
+    chain().db_update_i64(iterator, payer, data, len);
+}
+
+void db_remove_i64(int32_t iterator)
+{
+    chain().db_remove_i64(iterator);
+}
+
+int32_t db_get_i64(int32_t iterator, void* data, uint32_t len)
+{
+    return chain().db_get_i64(iterator, data, len);
+}
+
+int32_t db_next_i64(int32_t iterator, uint64_t* primary)
+{
+    return chain().db_next_i64(iterator, primary);
+}
+
+int32_t db_previous_i64(int32_t iterator, uint64_t* primary)
+{
+    return chain().db_previous_i64(iterator, primary);
+}
+
+int32_t db_find_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id)
+{
+    return chain().db_find_i64(code, scope, table, id);
+}
+
+int32_t db_lowerbound_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id)
+{
+    return chain().db_lowerbound_i64(code, scope, table, id);
+}
+
+int32_t db_upperbound_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id)
+{
+    return chain().db_upperbound_i64(code, scope, table, id);
+}
+
+int32_t db_end_i64(capi_name code, uint64_t scope, capi_name table)
+{
+    return chain().db_end_i64(code, scope, table);
+}
+
+}
+
+#define EOSIO_NATIVE_SECONDARY_INTRINSICS(IDX, TYPE, KIND) \
+extern "C" { \
+int32_t db_##IDX##_store(uint64_t scope, capi_name table, capi_name payer, uint64_t id, const TYPE* secondary) \
+{ \
+    return chain().idx_store(KIND, scope, table, payer, id, *secondary); \
+} \
+void db_##IDX##_update(int32_t iterator, capi_name payer, const TYPE* secondary) \
+{ \
+    chain().idx_update(KIND, iterator, payer, *secondary); \
+} \
+void db_##IDX##_remove(int32_t iterator) \
+{ \
+    chain().idx_remove(KIND, iterator); \
+} \
+int32_t db_##IDX##_next(int32_t iterator, uint64_t* primary) \
+{ \
+    return chain().idx_next(KIND, iterator, primary); \
+} \
+int32_t db_##IDX##_previous(int32_t iterator, uint64_t* primary) \
+{ \
+    return chain().idx_previous(KIND, iterator, primary); \
+} \
+int32_t db_##IDX##_find_primary(capi_name code, uint64_t scope, capi_name table, TYPE* secondary, uint64_t primary) \
+{ \
+    uint128_t key = 0; \
+    auto result = chain().idx_find_primary(KIND, code, scope, table, key, primary); \
+    *secondary = TYPE(key); \
+    return result; \
+} \
+int32_t db_##IDX##_find_secondary(capi_name code, uint64_t scope, capi_name table, const TYPE* secondary, \
+        uint64_t* primary) \
+{ \
+    return chain().idx_find_secondary(KIND, code, scope, table, *secondary, *primary); \
+} \
+int32_t db_##IDX##_lowerbound(capi_name code, uint64_t scope, capi_name table, TYPE* secondary, uint64_t* primary) \
+{ \
+    uint128_t key = *secondary; \
+    auto result = chain().idx_bound(KIND, code, scope, table, key, *primary, false); \
+    *secondary = TYPE(key); \
+    return result; \
+} \
+int32_t db_##IDX##_upperbound(capi_name code, uint64_t scope, capi_name table, TYPE* secondary, uint64_t* primary) \
+{ \
+    uint128_t key = *secondary; \
+    auto result = chain().idx_bound(KIND, code, scope, table, key, *primary, true); \
+    *secondary = TYPE(key); \
+    return result; \
+} \
+int32_t db_##IDX##_end(capi_name code, uint64_t scope, capi_name table) \
+{ \
+    return chain().idx_end(KIND, code, scope, table); \
+} \
+}
+
+EOSIO_NATIVE_SECONDARY_INTRINSICS(idx64, uint64_t, eosio::native::Chain::IDX64)
+EOSIO_NATIVE_SECONDARY_INTRINSICS(idx128, uint128_t, eosio::native::Chain::IDX128)
+
+#undef EOSIO_NATIVE_SECONDARY_INTRINSICS
@@ -0,0 +1,114 @@
+#pragma once
+/*
+ * Stand-in for the shared common.hpp of eosnow-bet contracts, only what eos.dice uses.
+ * Referrals keep shadow balances of inviters in table "referrals" like the shared implementation.
+ * */
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/singleton.hpp>
+#include <eosiolib/transaction.hpp>
+#include <string>
+
+namespace common {
+
+static constexpr eosio::symbol EOS_SYMBOL = eosio::symbol("EOS", 4);
+static constexpr eosio::symbol ANTE_SYMBOL = eosio::symbol("ANTE", 4);
+
+inline bool startsWith(const std::string& str, const std::string& prefix)
+{
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+namespace tables {
+
+struct TokenTransfer
+{
+    eosio::name from;
+    eosio::name to;
+    eosio::asset quantity;
+    std::string memo;
+
+    EOSLIB_SERIALIZE(TokenTransfer, (from)(to)(quantity)(memo))
+};
+
+struct Referral
+{
+    eosio::name account;                // inviter
+    eosio::asset balance;               // shadow balance accrued by losing bets of invited players
+
+    uint64_t primary_key() const
+    {
+        return account.value;
+    }
+
+    EOSLIB_SERIALIZE(Referral, (account)(balance))
+};
+typedef eosio::multi_index<"referrals"_n, Referral> Referrals;
+
+}//namespace tables
+
+class Referrals
+{
+public:
+    explicit Referrals(eosio::name self) : _self(self), _referrals(self, self.value)
+    {
+    }
+
+    void setBonusMultiplier(double multiplier)
+    {
+        _multiplier = multiplier;
+    }
+
+    // losing bets of invited players add multiplier * quantity to inviter
+    void on_player_bet(const eosio::name& player, const eosio::name& inviter, const eosio::asset& quantity,
+            const eosio::asset& reward)
+    {
+        if(!inviter || inviter == player || reward.amount > 0)
+        {
+            return;
+        }
+        auto bonus = eosio::asset(int64_t(quantity.amount * _multiplier), quantity.symbol);
+        auto it = _referrals.find(inviter.value);
+        if(it == _referrals.end())
+        {
+            _referrals.emplace(_self, [&](auto& r)
+            {
+                r.account = inviter;
+                r.balance = bonus;
+            });
+        }
+        else
+        {
+            _referrals.modify(it, eosio::same_payer, [&](auto& r)
+            {
+                r.balance += bonus;
+            });
+        }
+    }
+
+private:
+    eosio::name _self;
+    tables::Referrals _referrals;
+    double _multiplier = 0;
+};
+
+}//namespace common
+
+/*
+ * dispatch of own actions and notifications from other contracts
+ * */
+#define DISPATCH_ME(member, act) \
+    if(code == receiver && action == eosio::name(#act).value) \
+    { \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &member); \
+        return; \
+    }
+
+#define DISPATCH_EXTERNAL(contract, act, member) \
+    if(code == eosio::name(#contract).value && action == eosio::name(#act).value) \
+    { \
+        eosio::execute_action(eosio::name(receiver), eosio::name(code), &member); \
+        return; \
+    }
+
+#include <dice/random.hpp>
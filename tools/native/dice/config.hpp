@@ -0,0 +1,105 @@
+#pragma once
+/*
+ * Stand-in for config.hpp of eos.dice: initial values written on first action of contract.
+ * */
+#include <dice/tables.hpp>
+
+namespace dice {
+
+namespace RollType {
+enum : uint8_t
+{
+    LEFT = 1,
+    RIGHT = 2
+};
+}
+
+namespace TransactionNumber {
+enum : uint8_t
+{
+    BET = 1,
+    RESOLVED = 2,
+    MINT = 3,
+    DISTRIBUTE = 4
+};
+}
+
+namespace config {
+
+static constexpr uint32_t one_day_in_seconds = 24 * 60 * 60;
+static constexpr uint32_t one_week_in_seconds = 7 * one_day_in_seconds;
+static constexpr uint32_t one_month_in_seconds = 30 * one_day_in_seconds;
+
+inline tables::LeaderBoardConfig init_leader_board(uint8_t size, double percent, uint32_t period_length)
+{
+    tables::LeaderBoardConfig board{};
+    board.size = size;
+    board.bonus_percent = percent;
+    board.period_start = eosio::time_point(eosio::seconds(now()));
+    board.period_length = period_length;
+    return board;
+}
+
+inline tables::Config init_main_config(eosio::name self)
+{
+    tables::Config cfg{};
+    cfg.owner = self;
+    cfg.admin = self;
+    cfg.ante_token = "ante.token"_n;
+    cfg.enabled_betting = true;
+    cfg.enabled_minting = true;
+    cfg.enabled_payout = true;
+    cfg.eos_balance = eosio::asset(0, common::EOS_SYMBOL);
+    cfg.bets_id = tables::TableId{0, 0, 1000};
+    cfg.high_bets_id = tables::TableId{0, 0, 100};
+    cfg.rare_bets_id = tables::TableId{0, 0, 100};
+    cfg.high_bet_bound = eosio::asset(100000, common::EOS_SYMBOL);
+    cfg.rare_bet_bound = 5;
+    cfg.ante_in_eos = 1;
+    cfg.referral_multiplier = 0.1;
+    cfg.jackpot_percent = 0.005;
+    cfg.jackpot_balance = eosio::asset(0, common::EOS_SYMBOL);
+    cfg.total_payout = eosio::asset(0, common::EOS_SYMBOL);
+    cfg.total_bet_amount = eosio::asset(0, common::EOS_SYMBOL);
+    cfg.day_leader_board = init_leader_board(10, 0.001, one_day_in_seconds);
+    cfg.month_leader_board = init_leader_board(10, 0.01, one_month_in_seconds);
+    cfg.base_deferred_id = 0;
+    return cfg;
+}
+
+inline tables::DiceLimit init_dice_limits()
+{
+    tables::DiceLimit limits{};
+    limits.min_value = 1;
+    limits.max_value = 100;
+    limits.max_bet_percent = 0.02;
+    limits.max_bet_num = 100;
+    limits.min_bet = eosio::asset(1000, common::EOS_SYMBOL);
+    limits.balance_protect = eosio::asset(1000000, common::EOS_SYMBOL);
+    limits.platform_fee = 0.015;
+    return limits;
+}
+
+inline tables::BetToken init_bet_token()
+{
+    tables::BetToken token{};
+    token.name = common::EOS_SYMBOL;
+    return token;
+}
+
+inline void init_ante_bonuses(eosio::name self, tables::AnteBonusesConfig& bonuses)
+{
+    static const tables::AnteBonus defaults[] = {{1, 10, 1.0}, {11, 50, 1.5}, {51, 1000, 2.0}};
+    for(const auto& bonus: defaults)
+    {
+        bonuses.emplace(self, [&](auto& row)
+        {
+            row.begin = bonus.begin;
+            row.end = bonus.end;
+            row.multiplier = bonus.multiplier;
+        });
+    }
+}
+
+}//namespace config
+}//namespace dice
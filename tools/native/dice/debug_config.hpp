@@ -0,0 +1,5 @@
+#pragma once
+/*
+ * Stand-in for debug_config.hpp of eos.dice, debug builds use the same initial values.
+ * */
+#include <dice/config.hpp>
@@ -0,0 +1,33 @@
+#pragma once
+/*
+ * Stand-in for leaderboards.hpp of eos.dice: leader boards do not take part in native runs.
+ * */
+#include <dice/tables.hpp>
+
+namespace dice {
+
+class LeaderBoards
+{
+public:
+    LeaderBoards(eosio::name, tables::Config&)
+    {
+    }
+
+    void refresh()
+    {
+    }
+
+    void update_player_stats(const tables::Player&)
+    {
+    }
+
+    void on_distribution_failed(const eosio::action&)
+    {
+    }
+
+    void distributeLeadersBonuses(eosio::name, uint8_t, const std::vector<eosio::name>&, eosio::asset)
+    {
+    }
+};
+
+}//namespace dice
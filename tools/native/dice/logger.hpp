@@ -0,0 +1,12 @@
+#pragma once
+/*
+ * Stand-in for logger.hpp of eos.dice: log() prints to console of current action.
+ * */
+#include <eosiolib/print.hpp>
+#include <utility>
+
+template<typename... Args>
+inline void log(const char* format, Args&&... args)
+{
+    eosio::print_f(format, std::forward<Args>(args)...);
+}
@@ -0,0 +1,158 @@
+#pragma once
+/*
+ * eos.dice deployed on the in-memory chain: accounts, initial balances and helpers shared by native tools.
+ * Include this header in exactly one translation unit, it compiles the contract and the chain.
+ * */
+#include <dice/eos.dice.cpp>
+#include <chain.hpp>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dice {
+namespace host {
+
+using eosio::native::chain;
+
+const eosio::name dice_account = "eos.dice"_n;
+const eosio::name token_account = "eosio.token"_n;
+const eosio::name bank_account = "bank"_n;
+
+// player names p.aaaa, p.baaa, ...
+inline eosio::name player_name(uint32_t n)
+{
+    std::string str = "p.";
+    for(int i = 0; i < 4; ++i)
+    {
+        str += char('a' + n % 26);
+        n /= 26;
+    }
+    return eosio::name(std::string_view(str));
+}
+
+inline eosio::asset eos(int64_t amount)
+{
+    return eosio::asset(amount, common::EOS_SYMBOL);
+}
+
+/*
+ * creates token, contract, players with 10M EOS each and replenishes contract balance with 10M EOS
+ * */
+inline void deploy(uint32_t players)
+{
+    auto& c = chain();
+    c.set_token(token_account);
+    c.set_contract(dice_account, [](uint64_t receiver, uint64_t code, uint64_t action)
+    {
+        apply(receiver, code, action);
+    });
+    c.set_sink("ante.token"_n);
+    c.create_account(bank_account);
+    c.issue(bank_account, eos(1000000000000));
+    for(uint32_t i = 0; i < players; ++i)
+    {
+        c.create_account(player_name(i));
+        c.issue(player_name(i), eos(100000000000));
+    }
+    auto result = c.push(bank_account, token_account, "transfer"_n, bank_account, dice_account, eos(100000000000),
+            std::string("replenishment"));
+    eosio_assert(result.ok, "replenishment failed");
+}
+
+inline eosio::native::Chain::Result transfer(eosio::name from, eosio::name to, const eosio::asset& quantity,
+        const std::string& memo)
+{
+    return chain().push(from, token_account, "transfer"_n, from, to, quantity, memo);
+}
+
+// dice action signed by contract itself, contract is its own admin
+template<typename... Args>
+eosio::native::Chain::Result admin(eosio::name action, Args&&... args)
+{
+    return chain().push(dice_account, dice_account, action, std::forward<Args>(args)...);
+}
+
+inline capi_checksum256 hash(const capi_checksum256& value)
+{
+    capi_checksum256 result;
+    std::vector<uint8_t> buffer;
+    dice::sha256::detail::hash_one(dice::sha256::Kernel::SCALAR, value.hash, sizeof(value.hash), result.hash,
+            buffer);
+    return result;
+}
+
+/*
+ * house seeds of REVEAL mode form a hash chain which is revealed from its end: seed(k - 1) = sha256(seed(k)),
+ * bets placed before seed k is revealed are resolved by seed k + 1 in a later block
+ * */
+class HouseSeeds
+{
+public:
+    HouseSeeds(uint64_t length, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        _seeds.resize(length + 1);
+        for(size_t i = 0; i < sizeof(capi_checksum256) / sizeof(uint64_t); ++i)
+        {
+            auto word = rng();
+            std::memcpy(_seeds.back().hash + i * sizeof(word), &word, sizeof(word));
+        }
+        for(size_t i = length; i > 0; --i)
+        {
+            _seeds[i - 1] = hash(_seeds[i]);
+        }
+    }
+
+    // commitment of first seed
+    const capi_checksum256& commitment() const
+    {
+        return _seeds[0];
+    }
+
+    const capi_checksum256& next()
+    {
+        eosio_assert(_next + 1 < _seeds.size(), "house seeds are exhausted");
+        return _seeds[++_next];
+    }
+
+private:
+    std::vector<capi_checksum256> _seeds;
+    size_t _next = 0;
+};
+
+inline std::vector<uint64_t> pending_bets()
+{
+    std::vector<uint64_t> ids;
+    chain().read(dice_account, [&]()
+    {
+        tables::PendingBets pending(dice_account, dice_account.value);
+        for(const auto& bet: pending)
+        {
+            ids.push_back(bet.id);
+        }
+    });
+    return ids;
+}
+
+// pending bets resolved by house seed
+inline std::vector<uint64_t> pending_bets(const capi_checksum256& house_seed)
+{
+    auto commitment = hash(hash(house_seed));
+    std::vector<uint64_t> ids;
+    chain().read(dice_account, [&]()
+    {
+        tables::PendingBets pending(dice_account, dice_account.value);
+        for(const auto& bet: pending)
+        {
+            if(std::memcmp(bet.house_commitment.hash, commitment.hash, sizeof(commitment.hash)) == 0)
+            {
+                ids.push_back(bet.id);
+            }
+        }
+    });
+    return ids;
+}
+
+}//namespace host
+}//namespace dice
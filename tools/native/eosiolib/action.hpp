@@ -0,0 +1,99 @@
+#pragma once
+#include <eosiolib/datastream.hpp>
+#include <eosiolib/print.hpp>
+
+namespace eosio {
+
+template<typename T>
+T unpack_action_data()
+{
+    std::vector<char> buffer(action_data_size());
+    read_action_data(buffer.data(), buffer.size());
+    return unpack<T>(buffer.data(), buffer.size());
+}
+
+inline void require_recipient(name notify_account)
+{
+    ::require_recipient(notify_account.value);
+}
+
+template<typename... accounts>
+void require_recipient(name notify_account, accounts... remaining_accounts)
+{
+    ::require_recipient(notify_account.value);
+    require_recipient(remaining_accounts...);
+}
+
+inline void require_auth(name n)
+{
+    ::require_auth(n.value);
+}
+
+inline bool has_auth(name n)
+{
+    return ::has_auth(n.value);
+}
+
+inline bool is_account(name n)
+{
+    return ::is_account(n.value);
+}
+
+struct permission_level
+{
+    permission_level(name a, name p) : actor(a), permission(p)
+    {
+    }
+
+    permission_level()
+    {
+    }
+
+    name actor;
+    name permission;
+
+    friend bool operator==(const permission_level& a, const permission_level& b)
+    {
+        return a.actor == b.actor && a.permission == b.permission;
+    }
+
+    EOSLIB_SERIALIZE(permission_level, (actor)(permission))
+};
+
+struct action
+{
+    eosio::name account;
+    eosio::name name;
+    std::vector<permission_level> authorization;
+    std::vector<char> data;
+
+    action() = default;
+
+    template<typename T>
+    action(const permission_level& auth, eosio::name a, eosio::name n, T&& value)
+        : account(a), name(n), authorization(1, auth), data(pack(std::forward<T>(value)))
+    {
+    }
+
+    template<typename T>
+    action(std::vector<permission_level> auths, eosio::name a, eosio::name n, T&& value)
+        : account(a), name(n), authorization(std::move(auths)), data(pack(std::forward<T>(value)))
+    {
+    }
+
+    void send() const
+    {
+        auto serialize = pack(*this);
+        ::send_inline(serialize.data(), serialize.size());
+    }
+
+    template<typename T>
+    T data_as() const
+    {
+        return unpack<T>(data);
+    }
+
+    EOSLIB_SERIALIZE(action, (account)(name)(authorization)(data))
+};
+
+}//namespace eosio
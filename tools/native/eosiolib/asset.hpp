@@ -0,0 +1,182 @@
+#pragma once
+#include <eosiolib/symbol.hpp>
+#include <limits>
+
+namespace eosio {
+
+/*
+ * amount of tokens with symbol, arithmetic is checked the same way as in CDT
+ * */
+struct asset
+{
+    static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+    int64_t amount = 0;
+    eosio::symbol symbol;
+
+    asset() = default;
+
+    asset(int64_t a, class symbol s) : amount(a), symbol{s}
+    {
+        eosio_assert(is_amount_within_range(), "magnitude of asset amount must be less than 2^62");
+        eosio_assert(symbol.is_valid(), "invalid symbol name");
+    }
+
+    bool is_amount_within_range() const
+    {
+        return -max_amount <= amount && amount <= max_amount;
+    }
+
+    bool is_valid() const
+    {
+        return is_amount_within_range() && symbol.is_valid();
+    }
+
+    asset operator-() const
+    {
+        asset r = *this;
+        r.amount = -r.amount;
+        return r;
+    }
+
+    asset& operator-=(const asset& a)
+    {
+        eosio_assert(a.symbol == symbol, "attempt to subtract asset with different symbol");
+        amount -= a.amount;
+        eosio_assert(-max_amount <= amount, "subtraction underflow");
+        eosio_assert(amount <= max_amount, "subtraction overflow");
+        return *this;
+    }
+
+    asset& operator+=(const asset& a)
+    {
+        eosio_assert(a.symbol == symbol, "attempt to add asset with different symbol");
+        amount += a.amount;
+        eosio_assert(-max_amount <= amount, "addition underflow");
+        eosio_assert(amount <= max_amount, "addition overflow");
+        return *this;
+    }
+
+    friend asset operator+(const asset& a, const asset& b)
+    {
+        asset result = a;
+        result += b;
+        return result;
+    }
+
+    friend asset operator-(const asset& a, const asset& b)
+    {
+        asset result = a;
+        result -= b;
+        return result;
+    }
+
+    asset& operator*=(int64_t a)
+    {
+        int128_t tmp = int128_t(amount) * int128_t(a);
+        eosio_assert(tmp <= max_amount, "multiplication overflow");
+        eosio_assert(tmp >= -max_amount, "multiplication underflow");
+        amount = int64_t(tmp);
+        return *this;
+    }
+
+    friend asset operator*(const asset& a, int64_t b)
+    {
+        asset result = a;
+        result *= b;
+        return result;
+    }
+
+    friend asset operator*(int64_t b, const asset& a)
+    {
+        asset result = a;
+        result *= b;
+        return result;
+    }
+
+    asset& operator/=(int64_t a)
+    {
+        eosio_assert(a != 0, "divide by zero");
+        eosio_assert(!(amount == std::numeric_limits<int64_t>::min() && a == -1), "signed division overflow");
+        amount /= a;
+        return *this;
+    }
+
+    friend asset operator/(const asset& a, int64_t b)
+    {
+        asset result = a;
+        result /= b;
+        return result;
+    }
+
+    friend int64_t operator/(const asset& a, const asset& b)
+    {
+        eosio_assert(b.amount != 0, "divide by zero");
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount / b.amount;
+    }
+
+    friend bool operator==(const asset& a, const asset& b)
+    {
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount == b.amount;
+    }
+
+    friend bool operator!=(const asset& a, const asset& b)
+    {
+        return !(a == b);
+    }
+
+    friend bool operator<(const asset& a, const asset& b)
+    {
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount < b.amount;
+    }
+
+    friend bool operator<=(const asset& a, const asset& b)
+    {
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount <= b.amount;
+    }
+
+    friend bool operator>(const asset& a, const asset& b)
+    {
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount > b.amount;
+    }
+
+    friend bool operator>=(const asset& a, const asset& b)
+    {
+        eosio_assert(a.symbol == b.symbol, "comparison of assets with different symbols is not allowed");
+        return a.amount >= b.amount;
+    }
+
+    std::string to_string() const
+    {
+        uint64_t p10 = 1;
+        for(auto p = symbol.precision(); p > 0; --p)
+        {
+            p10 *= 10;
+        }
+        uint64_t magnitude = amount < 0 ? -uint64_t(amount) : uint64_t(amount);
+        std::string result = amount < 0 ? "-" : "";
+        result += std::to_string(magnitude / p10);
+        if(symbol.precision() > 0)
+        {
+            std::string fraction = std::to_string(magnitude % p10);
+            result += ".";
+            result += std::string(symbol.precision() - fraction.size(), '0');
+            result += fraction;
+        }
+        result += " ";
+        result += symbol.code().to_string();
+        return result;
+    }
+
+    void print() const
+    {
+        prints(to_string().c_str());
+    }
+};
+
+}//namespace eosio
@@ -0,0 +1,61 @@
+#pragma once
+#include <eosiolib/datastream.hpp>
+
+namespace eosio {
+
+class contract
+{
+public:
+    contract(name receiver, name code, datastream<const char*> ds) : _self(receiver), _code(code), _ds(ds)
+    {
+    }
+
+    name get_self() const
+    {
+        return _self;
+    }
+
+    name get_code() const
+    {
+        return _code;
+    }
+
+    datastream<const char*>& get_datastream()
+    {
+        return _ds;
+    }
+
+    const datastream<const char*>& get_datastream() const
+    {
+        return _ds;
+    }
+
+protected:
+    name _self;
+    name _code;
+    datastream<const char*> _ds = datastream<const char*>(nullptr, 0);
+};
+
+/*
+ * unpacks arguments of current action and calls member function of new contract object,
+ * the object is destroyed when the action returns
+ * */
+template<typename T, typename... Args>
+bool execute_action(name self, name code, void (T::*func)(Args...))
+{
+    size_t size = action_data_size();
+    std::vector<char> buffer(size);
+    if(size > 0)
+    {
+        read_action_data(buffer.data(), size);
+    }
+    std::tuple<std::decay_t<Args>...> args;
+    datastream<const char*> ds(buffer.data(), size);
+    ds >> args;
+
+    T inst(self, code, ds);
+    std::apply([&](auto&... a) { (inst.*func)(a...); }, args);
+    return true;
+}
+
+}//namespace eosio
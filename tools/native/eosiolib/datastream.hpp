@@ -0,0 +1,445 @@
+#pragma once
+#include <eosiolib/asset.hpp>
+#include <eosiolib/time.hpp>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace eosio {
+
+/*
+ * binary serialization with the same wire format as CDT:
+ * fixed size little endian scalars, LEB128 sizes of strings and containers
+ * */
+template<typename T>
+class datastream
+{
+public:
+    datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s)
+    {
+    }
+
+    void skip(size_t s)
+    {
+        _pos += s;
+    }
+
+    bool read(char* d, size_t s)
+    {
+        eosio_assert(size_t(_end - _pos) >= s, "read");
+        std::memcpy(d, _pos, s);
+        _pos += s;
+        return true;
+    }
+
+    bool write(const char* d, size_t s)
+    {
+        eosio_assert(_end - _pos >= (int32_t)s, "write");
+        std::memcpy((void*)_pos, d, s);
+        _pos += s;
+        return true;
+    }
+
+    T pos() const
+    {
+        return _pos;
+    }
+
+    bool valid() const
+    {
+        return _pos <= _end && _pos >= _start;
+    }
+
+    size_t tellp() const
+    {
+        return size_t(_pos - _start);
+    }
+
+    size_t remaining() const
+    {
+        return _end - _pos;
+    }
+
+private:
+    T _start;
+    T _pos;
+    T _end;
+};
+
+// stream which only counts bytes
+template<>
+class datastream<size_t>
+{
+public:
+    explicit datastream(size_t init_size = 0) : _size(init_size)
+    {
+    }
+
+    void skip(size_t s)
+    {
+        _size += s;
+    }
+
+    bool write(const char*, size_t s)
+    {
+        _size += s;
+        return true;
+    }
+
+    size_t tellp() const
+    {
+        return _size;
+    }
+
+private:
+    size_t _size;
+};
+
+/*
+ * variable length unsigned integer
+ * */
+struct unsigned_int
+{
+    unsigned_int(uint32_t v = 0) : value(v)
+    {
+    }
+
+    operator uint32_t() const
+    {
+        return value;
+    }
+
+    unsigned_int& operator=(uint32_t v)
+    {
+        value = v;
+        return *this;
+    }
+
+    uint32_t value;
+};
+
+template<typename T>
+constexpr bool is_raw_serializable_v = std::is_arithmetic<T>::value || std::is_same<T, uint128_t>::value ||
+        std::is_same<T, int128_t>::value;
+
+template<typename Stream, typename T, std::enable_if_t<is_raw_serializable_v<T>, int> = 0>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const T& value)
+{
+    ds.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    return ds;
+}
+
+template<typename Stream, typename T, std::enable_if_t<is_raw_serializable_v<T>, int> = 0>
+datastream<Stream>& operator>>(datastream<Stream>& ds, T& value)
+{
+    ds.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const unsigned_int& v)
+{
+    uint64_t val = v.value;
+    do
+    {
+        uint8_t b = uint8_t(val) & 0x7f;
+        val >>= 7;
+        b |= ((val > 0) << 7);
+        ds.write(reinterpret_cast<const char*>(&b), 1);
+    } while(val);
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, unsigned_int& vi)
+{
+    uint64_t v = 0;
+    char b = 0;
+    uint8_t by = 0;
+    do
+    {
+        ds.read(&b, 1);
+        v |= uint32_t(uint8_t(b) & 0x7f) << by;
+        by += 7;
+    } while(uint8_t(b) & 0x80);
+    vi.value = static_cast<uint32_t>(v);
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const capi_checksum256& cs)
+{
+    ds.write(reinterpret_cast<const char*>(cs.hash), sizeof(cs.hash));
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, capi_checksum256& cs)
+{
+    ds.read(reinterpret_cast<char*>(cs.hash), sizeof(cs.hash));
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const name& n)
+{
+    return ds << n.value;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, name& n)
+{
+    return ds >> n.value;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const symbol_code& sc)
+{
+    return ds << sc.raw();
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, symbol_code& sc)
+{
+    uint64_t raw = 0;
+    ds >> raw;
+    sc = symbol_code(raw);
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const symbol& s)
+{
+    return ds << s.raw();
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, symbol& s)
+{
+    uint64_t raw = 0;
+    ds >> raw;
+    s = symbol(raw);
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const asset& a)
+{
+    return ds << a.amount << a.symbol;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, asset& a)
+{
+    return ds >> a.amount >> a.symbol;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const time_point& t)
+{
+    return ds << t.elapsed._count;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, time_point& t)
+{
+    return ds >> t.elapsed._count;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const time_point_sec& t)
+{
+    return ds << t.utc_seconds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, time_point_sec& t)
+{
+    return ds >> t.utc_seconds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const std::string& v)
+{
+    ds << unsigned_int(v.size());
+    if(!v.empty())
+    {
+        ds.write(v.data(), v.size());
+    }
+    return ds;
+}
+
+template<typename Stream>
+datastream<Stream>& operator>>(datastream<Stream>& ds, std::string& v)
+{
+    unsigned_int s;
+    ds >> s;
+    v.resize(s.value);
+    if(s.value > 0)
+    {
+        ds.read(&v[0], s.value);
+    }
+    return ds;
+}
+
+template<typename Stream, typename T>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const std::vector<T>& v)
+{
+    ds << unsigned_int(v.size());
+    if constexpr(std::is_same<T, char>::value)
+    {
+        ds.write(v.data(), v.size());
+    }
+    else
+    {
+        for(const auto& i: v)
+        {
+            ds << i;
+        }
+    }
+    return ds;
+}
+
+template<typename Stream, typename T>
+datastream<Stream>& operator>>(datastream<Stream>& ds, std::vector<T>& v)
+{
+    unsigned_int s;
+    ds >> s;
+    v.resize(s.value);
+    if constexpr(std::is_same<T, char>::value)
+    {
+        ds.read(v.data(), v.size());
+    }
+    else
+    {
+        for(auto& i: v)
+        {
+            ds >> i;
+        }
+    }
+    return ds;
+}
+
+template<typename Stream, typename T>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const std::optional<T>& opt)
+{
+    char valid = opt.has_value();
+    ds << valid;
+    if(valid)
+    {
+        ds << *opt;
+    }
+    return ds;
+}
+
+template<typename Stream, typename T>
+datastream<Stream>& operator>>(datastream<Stream>& ds, std::optional<T>& opt)
+{
+    char valid = 0;
+    ds >> valid;
+    if(valid)
+    {
+        T val;
+        ds >> val;
+        opt = val;
+    }
+    else
+    {
+        opt.reset();
+    }
+    return ds;
+}
+
+template<typename Stream, typename T1, typename T2>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const std::pair<T1, T2>& t)
+{
+    return ds << std::get<0>(t) << std::get<1>(t);
+}
+
+template<typename Stream, typename T1, typename T2>
+datastream<Stream>& operator>>(datastream<Stream>& ds, std::pair<T1, T2>& t)
+{
+    return ds >> std::get<0>(t) >> std::get<1>(t);
+}
+
+template<typename Stream, typename... Args>
+datastream<Stream>& operator<<(datastream<Stream>& ds, const std::tuple<Args...>& t)
+{
+    std::apply([&](const auto&... args) { (ds << ... << args); }, t);
+    return ds;
+}
+
+template<typename Stream, typename... Args>
+datastream<Stream>& operator>>(datastream<Stream>& ds, std::tuple<Args...>& t)
+{
+    std::apply([&](auto&... args) { (ds >> ... >> args); }, t);
+    return ds;
+}
+
+template<typename T>
+size_t pack_size(const T& value)
+{
+    datastream<size_t> ps;
+    ps << value;
+    return ps.tellp();
+}
+
+template<typename T>
+std::vector<char> pack(const T& value)
+{
+    std::vector<char> result;
+    result.resize(pack_size(value));
+    datastream<char*> ds(result.data(), result.size());
+    ds << value;
+    return result;
+}
+
+template<typename T>
+T unpack(const char* buffer, size_t len)
+{
+    T result;
+    datastream<const char*> ds(buffer, len);
+    ds >> result;
+    return result;
+}
+
+template<typename T>
+T unpack(const std::vector<char>& bytes)
+{
+    return unpack<T>(bytes.data(), bytes.size());
+}
+
+}//namespace eosio
+
+/*
+ * EOSLIB_SERIALIZE(TYPE, (member1)(member2)...) without boost preprocessor:
+ * sequence elements are consumed by two macros which expand to each other, the last one is pasted with _END
+ * */
+#define EOSIO_NATIVE_CAT(a, b) EOSIO_NATIVE_CAT_I(a, b)
+#define EOSIO_NATIVE_CAT_I(a, b) a ## b
+#define EOSIO_NATIVE_WRITE_A(m) ds << t.m; EOSIO_NATIVE_WRITE_B
+#define EOSIO_NATIVE_WRITE_B(m) ds << t.m; EOSIO_NATIVE_WRITE_A
+#define EOSIO_NATIVE_WRITE_A_END
+#define EOSIO_NATIVE_WRITE_B_END
+#define EOSIO_NATIVE_READ_A(m) ds >> t.m; EOSIO_NATIVE_READ_B
+#define EOSIO_NATIVE_READ_B(m) ds >> t.m; EOSIO_NATIVE_READ_A
+#define EOSIO_NATIVE_READ_A_END
+#define EOSIO_NATIVE_READ_B_END
+
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS) \
+    template<typename DataStream> \
+    friend DataStream& operator<<(DataStream& ds, const TYPE& t) \
+    { \
+        EOSIO_NATIVE_CAT(EOSIO_NATIVE_WRITE_A MEMBERS, _END) \
+        return ds; \
+    } \
+    template<typename DataStream> \
+    friend DataStream& operator>>(DataStream& ds, TYPE& t) \
+    { \
+        EOSIO_NATIVE_CAT(EOSIO_NATIVE_READ_A MEMBERS, _END) \
+        return ds; \
+    }
@@ -0,0 +1,11 @@
+#pragma once
+#include <eosiolib/action.hpp>
+#include <eosiolib/asset.hpp>
+#include <eosiolib/contract.hpp>
+#include <eosiolib/crypto.h>
+#include <eosiolib/datastream.hpp>
+#include <eosiolib/multi_index.hpp>
+#include <eosiolib/name.hpp>
+#include <eosiolib/print.hpp>
+#include <eosiolib/symbol.hpp>
+#include <eosiolib/time.hpp>
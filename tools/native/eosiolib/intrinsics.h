@@ -0,0 +1,96 @@
+#pragma once
+#include <eosiolib/types.h>
+
+/*
+ * chain intrinsics with CDT signatures,
+ * native definitions are in tools/native/chain.hpp
+ * */
+extern "C" {
+
+// system
+void eosio_assert(uint32_t test, const char* msg);
+void eosio_assert_code(uint32_t test, uint64_t code);
+uint64_t current_time();
+uint32_t now();
+
+// action
+uint32_t read_action_data(void* msg, uint32_t len);
+uint32_t action_data_size();
+void require_recipient(capi_name name);
+void require_auth(capi_name name);
+void require_auth2(capi_name name, capi_name permission);
+bool has_auth(capi_name name);
+bool is_account(capi_name name);
+capi_name current_receiver();
+void send_inline(char* serialized_action, size_t size);
+
+// transaction
+void send_deferred(const uint128_t& sender_id, capi_name payer, const char* serialized_transaction, size_t size,
+        uint32_t replace_existing);
+int cancel_deferred(const uint128_t& sender_id);
+size_t transaction_size();
+int read_transaction(char* buffer, size_t size);
+int tapos_block_num();
+int tapos_block_prefix();
+uint32_t expiration();
+
+// crypto
+void sha256(const char* data, uint32_t length, capi_checksum256* hash);
+void assert_sha256(const char* data, uint32_t length, const capi_checksum256* hash);
+
+// print
+void prints(const char* cstr);
+void prints_l(const char* cstr, uint32_t len);
+void printi(int64_t value);
+void printui(uint64_t value);
+void printi128(const int128_t* value);
+void printui128(const uint128_t* value);
+void printdf(double value);
+void printn(uint64_t name);
+void printhex(const void* data, uint32_t datalen);
+
+// primary index
+int32_t db_store_i64(uint64_t scope, capi_name table, capi_name payer, uint64_t id, const void* data, uint32_t len);
+void db_update_i64(int32_t iterator, capi_name payer, const void* data, uint32_t len);
+void db_remove_i64(int32_t iterator);
+int32_t db_get_i64(int32_t iterator, void* data, uint32_t len);
+int32_t db_next_i64(int32_t iterator, uint64_t* primary);
+int32_t db_previous_i64(int32_t iterator, uint64_t* primary);
+int32_t db_find_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id);
+int32_t db_lowerbound_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id);
+int32_t db_upperbound_i64(capi_name code, uint64_t scope, capi_name table, uint64_t id);
+int32_t db_end_i64(capi_name code, uint64_t scope, capi_name table);
+
+// uint64_t secondary index
+int32_t db_idx64_store(uint64_t scope, capi_name table, capi_name payer, uint64_t id, const uint64_t* secondary);
+void db_idx64_update(int32_t iterator, capi_name payer, const uint64_t* secondary);
+void db_idx64_remove(int32_t iterator);
+int32_t db_idx64_next(int32_t iterator, uint64_t* primary);
+int32_t db_idx64_previous(int32_t iterator, uint64_t* primary);
+int32_t db_idx64_find_primary(capi_name code, uint64_t scope, capi_name table, uint64_t* secondary,
+        uint64_t primary);
+int32_t db_idx64_find_secondary(capi_name code, uint64_t scope, capi_name table, const uint64_t* secondary,
+        uint64_t* primary);
+int32_t db_idx64_lowerbound(capi_name code, uint64_t scope, capi_name table, uint64_t* secondary,
+        uint64_t* primary);
+int32_t db_idx64_upperbound(capi_name code, uint64_t scope, capi_name table, uint64_t* secondary,
+        uint64_t* primary);
+int32_t db_idx64_end(capi_name code, uint64_t scope, capi_name table);
+
+// uint128_t secondary index
+int32_t db_idx128_store(uint64_t scope, capi_name table, capi_name payer, uint64_t id, const uint128_t* secondary);
+void db_idx128_update(int32_t iterator, capi_name payer, const uint128_t* secondary);
+void db_idx128_remove(int32_t iterator);
+int32_t db_idx128_next(int32_t iterator, uint64_t* primary);
+int32_t db_idx128_previous(int32_t iterator, uint64_t* primary);
+int32_t db_idx128_find_primary(capi_name code, uint64_t scope, capi_name table, uint128_t* secondary,
+        uint64_t primary);
+int32_t db_idx128_find_secondary(capi_name code, uint64_t scope, capi_name table, const uint128_t* secondary,
+        uint64_t* primary);
+int32_t db_idx128_lowerbound(capi_name code, uint64_t scope, capi_name table, uint128_t* secondary,
+        uint64_t* primary);
+int32_t db_idx128_upperbound(capi_name code, uint64_t scope, capi_name table, uint128_t* secondary,
+        uint64_t* primary);
+int32_t db_idx128_end(capi_name code, uint64_t scope, capi_name table);
+
+}
@@ -0,0 +1,876 @@
+#pragma once
+#include <eosiolib/datastream.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+
+namespace eosio {
+
+constexpr static inline name same_payer{};
+
+template<name::raw IndexName, typename Extractor>
+struct indexed_by
+{
+    enum constants
+    {
+        index_name = static_cast<uint64_t>(IndexName)
+    };
+    typedef Extractor secondary_extractor_type;
+};
+
+template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun
+{
+    typedef typename std::remove_reference<Type>::type result_type;
+
+    Type operator()(const Class& x) const
+    {
+        return (x.*PtrToMemberFunction)();
+    }
+};
+
+namespace _multi_index_detail {
+
+template<typename T>
+struct secondary_index_db_functions;
+
+#define EOSIO_NATIVE_SECONDARY_INDEX(IDX, TYPE) \
+    template<> \
+    struct secondary_index_db_functions<TYPE> \
+    { \
+        static int32_t db_idx_store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const TYPE& secondary) \
+        { \
+            return db_##IDX##_store(scope, table, payer, id, &secondary); \
+        } \
+        static void db_idx_update(int32_t iterator, uint64_t payer, const TYPE& secondary) \
+        { \
+            db_##IDX##_update(iterator, payer, &secondary); \
+        } \
+        static void db_idx_remove(int32_t iterator) \
+        { \
+            db_##IDX##_remove(iterator); \
+        } \
+        static int32_t db_idx_next(int32_t iterator, uint64_t* primary) \
+        { \
+            return db_##IDX##_next(iterator, primary); \
+        } \
+        static int32_t db_idx_previous(int32_t iterator, uint64_t* primary) \
+        { \
+            return db_##IDX##_previous(iterator, primary); \
+        } \
+        static int32_t db_idx_find_primary(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary, \
+                TYPE& secondary) \
+        { \
+            return db_##IDX##_find_primary(code, scope, table, &secondary, primary); \
+        } \
+        static int32_t db_idx_find_secondary(uint64_t code, uint64_t scope, uint64_t table, const TYPE& secondary, \
+                uint64_t& primary) \
+        { \
+            return db_##IDX##_find_secondary(code, scope, table, &secondary, &primary); \
+        } \
+        static int32_t db_idx_lowerbound(uint64_t code, uint64_t scope, uint64_t table, TYPE& secondary, \
+                uint64_t& primary) \
+        { \
+            return db_##IDX##_lowerbound(code, scope, table, &secondary, &primary); \
+        } \
+        static int32_t db_idx_upperbound(uint64_t code, uint64_t scope, uint64_t table, TYPE& secondary, \
+                uint64_t& primary) \
+        { \
+            return db_##IDX##_upperbound(code, scope, table, &secondary, &primary); \
+        } \
+        static int32_t db_idx_end(uint64_t code, uint64_t scope, uint64_t table) \
+        { \
+            return db_##IDX##_end(code, scope, table); \
+        } \
+    };
+
+EOSIO_NATIVE_SECONDARY_INDEX(idx64, uint64_t)
+EOSIO_NATIVE_SECONDARY_INDEX(idx128, uint128_t)
+
+#undef EOSIO_NATIVE_SECONDARY_INDEX
+
+}//namespace _multi_index_detail
+
+/*
+ * multi_index over db_* intrinsics, same object cache and iterator rules as in CDT:
+ * objects are loaded once per instance, iterators point to cached objects,
+ * secondary index iterators are looked up lazily
+ * */
+template<name::raw TableName, typename T, typename... Indices>
+class multi_index
+{
+private:
+    static_assert((static_cast<uint64_t>(TableName) & 0x000000000000000FULL) == 0,
+            "multi_index does not support table names with a length greater than 12");
+
+    static constexpr size_t index_count = sizeof...(Indices);
+
+    enum next_primary_key_tags : uint64_t
+    {
+        no_available_primary_key = static_cast<uint64_t>(-2),
+        unset_next_primary_key = static_cast<uint64_t>(-1)
+    };
+
+    struct item: public T
+    {
+        template<typename Constructor>
+        item(const multi_index* idx, Constructor&& c) : __idx(idx)
+        {
+            c(*this);
+        }
+
+        const multi_index* __idx;
+        int32_t __primary_itr;
+        int32_t __iters[index_count + (index_count == 0)];
+    };
+
+    struct item_ptr
+    {
+        item_ptr(std::unique_ptr<item>&& i, uint64_t pk, int32_t pitr)
+            : _item(std::move(i)), _primary_key(pk), _primary_itr(pitr)
+        {
+        }
+
+        std::unique_ptr<item> _item;
+        uint64_t _primary_key;
+        int32_t _primary_itr;
+    };
+
+    template<size_t Number>
+    using index_definition = typename std::tuple_element<Number, std::tuple<Indices...>>::type;
+
+    template<size_t Number>
+    using secondary_key_of = std::decay_t<decltype(
+            typename index_definition<Number>::secondary_extractor_type()(std::declval<const T&>()))>;
+
+    template<size_t Number>
+    using db_functions = _multi_index_detail::secondary_index_db_functions<secondary_key_of<Number>>;
+
+    template<size_t Number>
+    static constexpr uint64_t index_table_name()
+    {
+        return (static_cast<uint64_t>(TableName) & 0xFFFFFFFFFFFFFFF0ULL) | (Number & 0x000000000000000FULL);
+    }
+
+    template<size_t Number>
+    static secondary_key_of<Number> extract_key(const T& obj)
+    {
+        return typename index_definition<Number>::secondary_extractor_type()(obj);
+    }
+
+    template<typename F, size_t... Numbers>
+    static void for_each_index(F&& f, std::index_sequence<Numbers...>)
+    {
+        (f(std::integral_constant<size_t, Numbers>()), ...);
+    }
+
+    template<typename F>
+    static void for_each_index(F&& f)
+    {
+        for_each_index(std::forward<F>(f), std::make_index_sequence<index_count>());
+    }
+
+    static constexpr size_t find_index_number(uint64_t index_name)
+    {
+        constexpr std::array<uint64_t, index_count + 1> names{static_cast<uint64_t>(Indices::index_name)..., 0};
+        for(size_t i = 0; i < index_count; ++i)
+        {
+            if(names[i] == index_name)
+            {
+                return i;
+            }
+        }
+        return index_count;
+    }
+
+    name _code;
+    uint64_t _scope;
+    mutable uint64_t _next_primary_key;
+    mutable std::vector<item_ptr> _items_vector;
+
+    const item& load_object_by_primary_iterator(int32_t itr) const
+    {
+        auto cached = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr)
+        {
+            return ptr._primary_itr == itr;
+        });
+        if(cached != _items_vector.rend())
+        {
+            return *cached->_item;
+        }
+
+        auto size = db_get_i64(itr, nullptr, 0);
+        eosio_assert(size >= 0, "error reading iterator");
+        std::vector<char> buffer(size);
+        db_get_i64(itr, buffer.data(), uint32_t(size));
+
+        auto ptr = std::make_unique<item>(this, [&](auto& i)
+        {
+            T& val = static_cast<T&>(i);
+            datastream<const char*> ds(buffer.data(), buffer.size());
+            ds >> val;
+            i.__primary_itr = itr;
+            std::fill(std::begin(i.__iters), std::end(i.__iters), -1);
+        });
+        const item* result = ptr.get();
+        auto pk = result->primary_key();
+        _items_vector.emplace_back(std::move(ptr), pk, itr);
+        return *result;
+    }
+
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef const T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b)
+        {
+            return a._item == b._item;
+        }
+
+        friend bool operator!=(const const_iterator& a, const const_iterator& b)
+        {
+            return a._item != b._item;
+        }
+
+        const T& operator*() const
+        {
+            eosio_assert(_item != nullptr, "cannot dereference end iterator");
+            return *static_cast<const T*>(_item);
+        }
+
+        const T* operator->() const
+        {
+            return &operator*();
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator result(*this);
+            ++(*this);
+            return result;
+        }
+
+        const_iterator operator--(int)
+        {
+            const_iterator result(*this);
+            --(*this);
+            return result;
+        }
+
+        const_iterator& operator++()
+        {
+            eosio_assert(_item != nullptr, "cannot increment end iterator");
+            uint64_t next_pk;
+            auto next_itr = db_next_i64(_item->__primary_itr, &next_pk);
+            if(next_itr < 0)
+            {
+                _item = nullptr;
+            }
+            else
+            {
+                _item = &_multidx->load_object_by_primary_iterator(next_itr);
+            }
+            return *this;
+        }
+
+        const_iterator& operator--()
+        {
+            uint64_t prev_pk;
+            int32_t prev_itr = -1;
+            if(!_item)
+            {
+                auto ei = db_end_i64(_multidx->get_code().value, _multidx->get_scope(), static_cast<uint64_t>(TableName));
+                eosio_assert(ei != -1, "cannot decrement end iterator when the table is empty");
+                prev_itr = db_previous_i64(ei, &prev_pk);
+                eosio_assert(prev_itr >= 0, "cannot decrement end iterator when the table is empty");
+            }
+            else
+            {
+                prev_itr = db_previous_i64(_item->__primary_itr, &prev_pk);
+                eosio_assert(prev_itr >= 0, "cannot decrement iterator at beginning of table");
+            }
+            _item = &_multidx->load_object_by_primary_iterator(prev_itr);
+            return *this;
+        }
+
+        const_iterator() = default;
+
+    private:
+        friend class multi_index;
+
+        const_iterator(const multi_index* mi, const item* i = nullptr) : _multidx(mi), _item(i)
+        {
+        }
+
+        const multi_index* _multidx = nullptr;
+        const item* _item = nullptr;
+    };
+
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /*
+     * secondary index number Number of this table
+     * */
+    template<name::raw IndexName, size_t Number>
+    class index
+    {
+    public:
+        typedef secondary_key_of<Number> secondary_key_type;
+        typedef typename index_definition<Number>::secondary_extractor_type secondary_extractor_type;
+
+        static constexpr uint64_t name()
+        {
+            return index_table_name<Number>();
+        }
+
+        static constexpr uint64_t number()
+        {
+            return Number;
+        }
+
+        class const_iterator
+        {
+        public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef const T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const T* pointer;
+            typedef const T& reference;
+
+            friend bool operator==(const const_iterator& a, const const_iterator& b)
+            {
+                return a._item == b._item;
+            }
+
+            friend bool operator!=(const const_iterator& a, const const_iterator& b)
+            {
+                return a._item != b._item;
+            }
+
+            const T& operator*() const
+            {
+                eosio_assert(_item != nullptr, "cannot dereference end iterator");
+                return *static_cast<const T*>(_item);
+            }
+
+            const T* operator->() const
+            {
+                return &operator*();
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator result(*this);
+                ++(*this);
+                return result;
+            }
+
+            const_iterator operator--(int)
+            {
+                const_iterator result(*this);
+                --(*this);
+                return result;
+            }
+
+            const_iterator& operator++()
+            {
+                eosio_assert(_item != nullptr, "cannot increment end iterator");
+                lookup_secondary_iterator();
+                uint64_t next_pk = 0;
+                auto next_itr = db_functions<Number>::db_idx_next(_item->__iters[Number], &next_pk);
+                if(next_itr < 0)
+                {
+                    _item = nullptr;
+                    return *this;
+                }
+                _item = &_idx->load(next_pk, next_itr);
+                return *this;
+            }
+
+            const_iterator& operator--()
+            {
+                uint64_t prev_pk = 0;
+                int32_t prev_itr = -1;
+                if(!_item)
+                {
+                    auto ei = db_functions<Number>::db_idx_end(_idx->get_code().value, _idx->get_scope(), name());
+                    eosio_assert(ei != -1, "cannot decrement end iterator when the index is empty");
+                    prev_itr = db_functions<Number>::db_idx_previous(ei, &prev_pk);
+                    eosio_assert(prev_itr >= 0, "cannot decrement end iterator when the index is empty");
+                }
+                else
+                {
+                    lookup_secondary_iterator();
+                    prev_itr = db_functions<Number>::db_idx_previous(_item->__iters[Number], &prev_pk);
+                    eosio_assert(prev_itr >= 0, "cannot decrement iterator at beginning of index");
+                }
+                _item = &_idx->load(prev_pk, prev_itr);
+                return *this;
+            }
+
+            const_iterator() = default;
+
+        private:
+            friend class index;
+
+            const_iterator(const index* idx, const item* i = nullptr) : _idx(idx), _item(i)
+            {
+            }
+
+            void lookup_secondary_iterator()
+            {
+                if(_item->__iters[Number] == -1)
+                {
+                    secondary_key_type temp_secondary_key;
+                    auto idxitr = db_functions<Number>::db_idx_find_primary(_idx->get_code().value, _idx->get_scope(),
+                            name(), _item->primary_key(), temp_secondary_key);
+                    const_cast<item*>(_item)->__iters[Number] = idxitr;
+                }
+            }
+
+            const index* _idx = nullptr;
+            const item* _item = nullptr;
+        };
+
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        const_iterator cbegin() const
+        {
+            return lower_bound(std::numeric_limits<secondary_key_type>::lowest());
+        }
+
+        const_iterator begin() const
+        {
+            return cbegin();
+        }
+
+        const_iterator cend() const
+        {
+            return const_iterator(this);
+        }
+
+        const_iterator end() const
+        {
+            return cend();
+        }
+
+        const_reverse_iterator crbegin() const
+        {
+            return std::make_reverse_iterator(cend());
+        }
+
+        const_reverse_iterator rbegin() const
+        {
+            return crbegin();
+        }
+
+        const_reverse_iterator crend() const
+        {
+            return std::make_reverse_iterator(cbegin());
+        }
+
+        const_reverse_iterator rend() const
+        {
+            return crend();
+        }
+
+        const_iterator find(secondary_key_type secondary) const
+        {
+            auto lb = lower_bound(secondary);
+            auto e = cend();
+            if(lb == e)
+            {
+                return e;
+            }
+            if(secondary != secondary_extractor_type()(*lb))
+            {
+                return e;
+            }
+            return lb;
+        }
+
+        const_iterator require_find(secondary_key_type secondary, const char* error_msg = "unable to find secondary key") const
+        {
+            auto result = find(secondary);
+            eosio_assert(result != cend(), error_msg);
+            return result;
+        }
+
+        const T& get(secondary_key_type secondary, const char* error_msg = "unable to find secondary key") const
+        {
+            return *require_find(secondary, error_msg);
+        }
+
+        const_iterator lower_bound(secondary_key_type secondary) const
+        {
+            uint64_t primary = 0;
+            auto itr = db_functions<Number>::db_idx_lowerbound(get_code().value, get_scope(), name(), secondary, primary);
+            if(itr < 0)
+            {
+                return cend();
+            }
+            return const_iterator(this, &load(primary, itr));
+        }
+
+        const_iterator upper_bound(secondary_key_type secondary) const
+        {
+            uint64_t primary = 0;
+            auto itr = db_functions<Number>::db_idx_upperbound(get_code().value, get_scope(), name(), secondary, primary);
+            if(itr < 0)
+            {
+                return cend();
+            }
+            return const_iterator(this, &load(primary, itr));
+        }
+
+        const_iterator iterator_to(const T& obj) const
+        {
+            const auto& objitem = static_cast<const item&>(obj);
+            eosio_assert(objitem.__idx == _multidx, "object passed to iterator_to is not in multi_index");
+            return const_iterator(this, &objitem);
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, eosio::name payer, Lambda&& updater)
+        {
+            eosio_assert(itr != cend(), "cannot pass end iterator to modify");
+            _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        const_iterator erase(const_iterator itr)
+        {
+            eosio_assert(itr != cend(), "cannot pass end iterator to erase");
+            const auto& obj = *itr;
+            ++itr;
+            _multidx->erase(obj);
+            return itr;
+        }
+
+        eosio::name get_code() const
+        {
+            return _multidx->get_code();
+        }
+
+        uint64_t get_scope() const
+        {
+            return _multidx->get_scope();
+        }
+
+        static auto extract_secondary_key(const T& obj)
+        {
+            return secondary_extractor_type()(obj);
+        }
+
+    private:
+        friend class multi_index;
+
+        explicit index(multi_index* idx) : _multidx(idx)
+        {
+        }
+
+        // object with primary key, secondary iterator is remembered in the cached object
+        const item& load(uint64_t primary, int32_t secondary_itr) const
+        {
+            const auto& obj = *_multidx->find(primary);
+            auto& mi = const_cast<item&>(static_cast<const item&>(obj));
+            mi.__iters[Number] = secondary_itr;
+            return mi;
+        }
+
+        multi_index* _multidx;
+    };
+
+    multi_index(name code, uint64_t scope) : _code(code), _scope(scope), _next_primary_key(unset_next_primary_key)
+    {
+    }
+
+    multi_index(const multi_index&) = delete;
+    multi_index& operator=(const multi_index&) = delete;
+
+    name get_code() const
+    {
+        return _code;
+    }
+
+    uint64_t get_scope() const
+    {
+        return _scope;
+    }
+
+    const_iterator cbegin() const
+    {
+        return lower_bound(std::numeric_limits<uint64_t>::lowest());
+    }
+
+    const_iterator begin() const
+    {
+        return cbegin();
+    }
+
+    const_iterator cend() const
+    {
+        return const_iterator(this);
+    }
+
+    const_iterator end() const
+    {
+        return cend();
+    }
+
+    const_reverse_iterator crbegin() const
+    {
+        return std::make_reverse_iterator(cend());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+        return crbegin();
+    }
+
+    const_reverse_iterator crend() const
+    {
+        return std::make_reverse_iterator(cbegin());
+    }
+
+    const_reverse_iterator rend() const
+    {
+        return crend();
+    }
+
+    const_iterator lower_bound(uint64_t primary) const
+    {
+        auto itr = db_lowerbound_i64(_code.value, _scope, static_cast<uint64_t>(TableName), primary);
+        if(itr < 0)
+        {
+            return end();
+        }
+        return const_iterator(this, &load_object_by_primary_iterator(itr));
+    }
+
+    const_iterator upper_bound(uint64_t primary) const
+    {
+        auto itr = db_upperbound_i64(_code.value, _scope, static_cast<uint64_t>(TableName), primary);
+        if(itr < 0)
+        {
+            return end();
+        }
+        return const_iterator(this, &load_object_by_primary_iterator(itr));
+    }
+
+    uint64_t available_primary_key() const
+    {
+        if(_next_primary_key == unset_next_primary_key)
+        {
+            // this is the first time available_primary_key() is called for this multi_index instance
+            if(begin() == end())
+            {
+                _next_primary_key = 0;
+            }
+            else
+            {
+                auto itr = --end();
+                auto pk = itr->primary_key();
+                _next_primary_key = pk >= no_available_primary_key ? uint64_t(no_available_primary_key) : pk + 1;
+            }
+        }
+        eosio_assert(_next_primary_key < no_available_primary_key,
+                "next primary key in table is at autoincrement limit");
+        return _next_primary_key;
+    }
+
+    template<name::raw IndexName>
+    auto get_index()
+    {
+        constexpr size_t number = find_index_number(static_cast<uint64_t>(IndexName));
+        static_assert(number < index_count, "name provided is not the name of any secondary index within multi_index");
+        return index<IndexName, number>(this);
+    }
+
+    template<name::raw IndexName>
+    auto get_index() const
+    {
+        constexpr size_t number = find_index_number(static_cast<uint64_t>(IndexName));
+        static_assert(number < index_count, "name provided is not the name of any secondary index within multi_index");
+        return index<IndexName, number>(const_cast<multi_index*>(this));
+    }
+
+    const_iterator iterator_to(const T& obj) const
+    {
+        const auto& objitem = static_cast<const item&>(obj);
+        eosio_assert(objitem.__idx == this, "object passed to iterator_to is not in multi_index");
+        return const_iterator(this, &objitem);
+    }
+
+    template<typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor)
+    {
+        eosio_assert(_code.value == current_receiver(), "cannot create objects in table of another contract");
+
+        auto ptr = std::make_unique<item>(this, [&](auto& i)
+        {
+            T& obj = static_cast<T&>(i);
+            constructor(obj);
+
+            auto buffer = pack(obj);
+            auto pk = obj.primary_key();
+            i.__primary_itr = db_store_i64(_scope, static_cast<uint64_t>(TableName), payer.value, pk, buffer.data(),
+                    buffer.size());
+
+            if(pk >= _next_primary_key)
+            {
+                _next_primary_key = pk >= no_available_primary_key ? uint64_t(no_available_primary_key) : pk + 1;
+            }
+
+            for_each_index([&](auto number)
+            {
+                constexpr size_t n = decltype(number)::value;
+                i.__iters[n] = db_functions<n>::db_idx_store(_scope, index_table_name<n>(), payer.value, pk,
+                        extract_key<n>(obj));
+            });
+        });
+
+        const item* result = ptr.get();
+        auto pk = result->primary_key();
+        auto pitr = result->__primary_itr;
+        _items_vector.emplace_back(std::move(ptr), pk, pitr);
+        return const_iterator(this, result);
+    }
+
+    template<typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater)
+    {
+        eosio_assert(itr != end(), "cannot pass end iterator to modify");
+        modify(*itr, payer, std::forward<Lambda>(updater));
+    }
+
+    template<typename Lambda>
+    void modify(const T& obj, name payer, Lambda&& updater)
+    {
+        const auto& objitem = static_cast<const item&>(obj);
+        eosio_assert(objitem.__idx == this, "object passed to modify is not in multi_index");
+        auto& mutableitem = const_cast<item&>(objitem);
+        eosio_assert(_code.value == current_receiver(), "cannot modify objects in table of another contract");
+
+        std::array<uint128_t, index_count + 1> old_keys{};
+        for_each_index([&](auto number)
+        {
+            constexpr size_t n = decltype(number)::value;
+            old_keys[n] = extract_key<n>(obj);
+        });
+
+        auto pk = obj.primary_key();
+        updater(static_cast<T&>(mutableitem));
+        eosio_assert(pk == obj.primary_key(), "updater cannot change primary key when modifying an object");
+
+        auto buffer = pack(static_cast<const T&>(obj));
+        db_update_i64(objitem.__primary_itr, payer.value, buffer.data(), buffer.size());
+
+        if(pk >= _next_primary_key)
+        {
+            _next_primary_key = pk >= no_available_primary_key ? uint64_t(no_available_primary_key) : pk + 1;
+        }
+
+        for_each_index([&](auto number)
+        {
+            constexpr size_t n = decltype(number)::value;
+            auto secondary = extract_key<n>(obj);
+            if(old_keys[n] != secondary)
+            {
+                auto indexitr = mutableitem.__iters[n];
+                if(indexitr < 0)
+                {
+                    secondary_key_of<n> temp_secondary_key;
+                    indexitr = mutableitem.__iters[n] = db_functions<n>::db_idx_find_primary(_code.value, _scope,
+                            index_table_name<n>(), pk, temp_secondary_key);
+                }
+                db_functions<n>::db_idx_update(indexitr, payer.value, secondary);
+            }
+        });
+    }
+
+    const T& get(uint64_t primary, const char* error_msg = "unable to find key") const
+    {
+        auto result = find(primary);
+        eosio_assert(result != cend(), error_msg);
+        return *result;
+    }
+
+    const_iterator find(uint64_t primary) const
+    {
+        auto cached = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr)
+        {
+            return ptr._item->primary_key() == primary;
+        });
+        if(cached != _items_vector.rend())
+        {
+            return iterator_to(*(cached->_item));
+        }
+
+        auto itr = db_find_i64(_code.value, _scope, static_cast<uint64_t>(TableName), primary);
+        if(itr < 0)
+        {
+            return end();
+        }
+        return iterator_to(static_cast<const T&>(load_object_by_primary_iterator(itr)));
+    }
+
+    const_iterator require_find(uint64_t primary, const char* error_msg = "unable to find key") const
+    {
+        auto result = find(primary);
+        eosio_assert(result != cend(), error_msg);
+        return result;
+    }
+
+    const_iterator erase(const_iterator itr)
+    {
+        eosio_assert(itr != end(), "cannot pass end iterator to erase");
+        const auto& obj = *itr;
+        ++itr;
+        erase(obj);
+        return itr;
+    }
+
+    void erase(const T& obj)
+    {
+        const auto& objitem = static_cast<const item&>(obj);
+        eosio_assert(objitem.__idx == this, "object passed to erase is not in multi_index");
+        eosio_assert(_code.value == current_receiver(), "cannot erase objects in table of another contract");
+
+        auto pk = objitem.primary_key();
+        auto cached = std::find_if(_items_vector.rbegin(), _items_vector.rend(), [&](const item_ptr& ptr)
+        {
+            return ptr._item->primary_key() == pk;
+        });
+        eosio_assert(cached != _items_vector.rend(), "attempt to remove object that was not in multi_index");
+
+        db_remove_i64(objitem.__primary_itr);
+
+        for_each_index([&](auto number)
+        {
+            constexpr size_t n = decltype(number)::value;
+            auto i = objitem.__iters[n];
+            if(i < 0)
+            {
+                secondary_key_of<n> secondary;
+                i = db_functions<n>::db_idx_find_primary(_code.value, _scope, index_table_name<n>(), pk, secondary);
+            }
+            if(i >= 0)
+            {
+                db_functions<n>::db_idx_remove(i);
+            }
+        });
+
+        _items_vector.erase(--(cached.base()));
+    }
+};
+
+}//namespace eosio
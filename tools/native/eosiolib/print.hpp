@@ -0,0 +1,98 @@
+#pragma once
+#include <eosiolib/intrinsics.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace eosio {
+
+inline void print(const char* ptr)
+{
+    prints(ptr);
+}
+
+inline void print(const std::string& s)
+{
+    prints_l(s.c_str(), s.size());
+}
+
+inline void print(const char c)
+{
+    prints_l(&c, 1);
+}
+
+inline void print(bool value)
+{
+    prints(value ? "true" : "false");
+}
+
+inline void print(float value)
+{
+    printdf(value);
+}
+
+inline void print(double value)
+{
+    printdf(value);
+}
+
+inline void print(int128_t num)
+{
+    printi128(&num);
+}
+
+inline void print(uint128_t num)
+{
+    printui128(&num);
+}
+
+template<typename T, std::enable_if_t<std::is_integral<std::decay_t<T>>::value, int> = 0>
+inline void print(T num)
+{
+    if constexpr(std::is_signed<std::decay_t<T>>::value)
+    {
+        printi(num);
+    }
+    else
+    {
+        printui(num);
+    }
+}
+
+// classes print themselves
+template<typename T, std::enable_if_t<std::is_class<std::decay_t<T>>::value, int> = 0>
+inline void print(const T& t)
+{
+    t.print();
+}
+
+template<typename Arg, typename Arg2, typename... Args>
+void print(Arg&& a, Arg2&& a2, Args&&... args)
+{
+    print(std::forward<Arg>(a));
+    print(std::forward<Arg2>(a2), std::forward<Args>(args)...);
+}
+
+inline void print_f(const char* s)
+{
+    prints(s);
+}
+
+// every '%' of format is replaced by the next argument
+template<typename Arg, typename... Args>
+inline void print_f(const char* s, Arg val, Args... rest)
+{
+    while(*s != '\0')
+    {
+        if(*s == '%')
+        {
+            print(val);
+            print_f(s + 1, rest...);
+            return;
+        }
+        prints_l(s, 1);
+        s++;
+    }
+}
+
+}//namespace eosio
@@ -0,0 +1,167 @@
+#pragma once
+#include <eosiolib/name.hpp>
+
+namespace eosio {
+
+/*
+ * up to 7 upper case letters packed into 56 bits, first letter in the lowest byte
+ * */
+class symbol_code
+{
+public:
+    constexpr symbol_code() = default;
+
+    constexpr explicit symbol_code(uint64_t raw) : value(raw)
+    {
+    }
+
+    constexpr explicit symbol_code(std::string_view str) : value(0)
+    {
+        if(str.size() > 7)
+        {
+            eosio_assert(false, "string is too long to be a valid symbol_code");
+        }
+        for(auto it = str.rbegin(); it != str.rend(); ++it)
+        {
+            if(*it < 'A' || *it > 'Z')
+            {
+                eosio_assert(false, "only uppercase letters allowed in symbol_code string");
+            }
+            value <<= 8;
+            value |= *it;
+        }
+    }
+
+    constexpr bool is_valid() const
+    {
+        auto sym = value;
+        for(int i = 0; i < 7; ++i)
+        {
+            char c = char(sym & 0xFF);
+            if(!('A' <= c && c <= 'Z'))
+            {
+                return false;
+            }
+            sym >>= 8;
+            if(!(sym & 0xFF))
+            {
+                do
+                {
+                    sym >>= 8;
+                    if(sym & 0xFF)
+                    {
+                        return false;
+                    }
+                    ++i;
+                } while(i < 7);
+            }
+        }
+        return true;
+    }
+
+    constexpr uint64_t raw() const
+    {
+        return value;
+    }
+
+    std::string to_string() const
+    {
+        std::string result;
+        for(auto v = value; v > 0; v >>= 8)
+        {
+            result += char(v & 0xFF);
+        }
+        return result;
+    }
+
+    friend constexpr bool operator==(const symbol_code& a, const symbol_code& b)
+    {
+        return a.value == b.value;
+    }
+
+    friend constexpr bool operator!=(const symbol_code& a, const symbol_code& b)
+    {
+        return a.value != b.value;
+    }
+
+    friend constexpr bool operator<(const symbol_code& a, const symbol_code& b)
+    {
+        return a.value < b.value;
+    }
+
+private:
+    uint64_t value = 0;
+};
+
+/*
+ * symbol code and precision, precision is the lowest byte
+ * */
+class symbol
+{
+public:
+    constexpr symbol() = default;
+
+    constexpr explicit symbol(uint64_t raw) : value(raw)
+    {
+    }
+
+    constexpr symbol(symbol_code sc, uint8_t precision) : value((sc.raw() << 8) | precision)
+    {
+    }
+
+    constexpr symbol(std::string_view code, uint8_t precision) : value((symbol_code(code).raw() << 8) | precision)
+    {
+    }
+
+    constexpr bool is_valid() const
+    {
+        return code().is_valid();
+    }
+
+    constexpr uint8_t precision() const
+    {
+        return value & 0xFF;
+    }
+
+    constexpr symbol_code code() const
+    {
+        return symbol_code(value >> 8);
+    }
+
+    constexpr uint64_t raw() const
+    {
+        return value;
+    }
+
+    constexpr explicit operator bool() const
+    {
+        return value != 0;
+    }
+
+    void print() const
+    {
+        printui(precision());
+        prints(",");
+        prints(code().to_string().c_str());
+    }
+
+    friend constexpr bool operator==(const symbol& a, const symbol& b)
+    {
+        return a.value == b.value;
+    }
+
+    friend constexpr bool operator!=(const symbol& a, const symbol& b)
+    {
+        return a.value != b.value;
+    }
+
+    friend constexpr bool operator<(const symbol& a, const symbol& b)
+    {
+        return a.value < b.value;
+    }
+
+private:
+    uint64_t value = 0;
+};
+
+}//namespace eosio
@@ -0,0 +1,87 @@
+#pragma once
+#include <eosiolib/action.hpp>
+
+namespace eosio {
+
+typedef std::tuple<uint16_t, std::vector<char>> extension;
+typedef std::vector<extension> extensions_type;
+
+class transaction_header
+{
+public:
+    transaction_header(time_point_sec exp = time_point_sec(now() + 60))
+        : expiration(exp), ref_block_num(0), ref_block_prefix(0), max_net_usage_words(0), max_cpu_usage_ms(0),
+          delay_sec(0)
+    {
+    }
+
+    time_point_sec expiration;
+    uint16_t ref_block_num;
+    uint32_t ref_block_prefix;
+    unsigned_int max_net_usage_words;
+    uint8_t max_cpu_usage_ms;
+    unsigned_int delay_sec;
+
+    EOSLIB_SERIALIZE(transaction_header,
+        (expiration)(ref_block_num)(ref_block_prefix)(max_net_usage_words)(max_cpu_usage_ms)(delay_sec))
+};
+
+class transaction: public transaction_header
+{
+public:
+    transaction(time_point_sec exp = time_point_sec(now() + 60)) : transaction_header(exp)
+    {
+    }
+
+    void send(const uint128_t& sender_id, name payer, bool replace_existing = false) const
+    {
+        auto serialize = pack(*this);
+        send_deferred(sender_id, payer.value, serialize.data(), serialize.size(), replace_existing);
+    }
+
+    std::vector<action> context_free_actions;
+    std::vector<action> actions;
+    extensions_type transaction_extensions;
+
+    template<typename DataStream>
+    friend DataStream& operator<<(DataStream& ds, const transaction& t)
+    {
+        ds << static_cast<const transaction_header&>(t);
+        return ds << t.context_free_actions << t.actions << t.transaction_extensions;
+    }
+
+    template<typename DataStream>
+    friend DataStream& operator>>(DataStream& ds, transaction& t)
+    {
+        ds >> static_cast<transaction_header&>(t);
+        return ds >> t.context_free_actions >> t.actions >> t.transaction_extensions;
+    }
+};
+
+/*
+ * data of eosio::onerror action which is delivered to sender of failed deferred transaction
+ * */
+struct onerror
+{
+    uint128_t sender_id;
+    std::vector<char> sent_trx;
+
+    static onerror from_current_action()
+    {
+        return unpack_action_data<onerror>();
+    }
+
+    transaction unpack_sent_trx() const
+    {
+        return unpack<transaction>(sent_trx);
+    }
+
+    EOSLIB_SERIALIZE(onerror, (sender_id)(sent_trx))
+};
+
+inline void send_inline(action& act)
+{
+    act.send();
+}
+
+}//namespace eosio
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * C types of eosiolib, layouts are the same as in CDT:
+ * checksums are 16 byte aligned, so structs which embed them get the same padding as in wasm
+ * */
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+typedef uint64_t capi_name;
+
+struct __attribute__((aligned (16))) capi_checksum256
+{
+    uint8_t hash[32];
+};
+
+struct __attribute__((aligned (16))) capi_checksum160
+{
+    uint8_t hash[20];
+};
+
+struct __attribute__((aligned (16))) capi_checksum512
+{
+    uint8_t hash[64];
+};
@@ -0,0 +1,171 @@
+/*
+ * Check of fixed point rewards of dice::rules against the floating point formula they replaced.
+ *
+ * For every platform fee and every amount of winners reward(amount, payout_multipliers()[num]) is compared with
+ * int64_t(amount * (1 - platform_fee) * (100.0 / num)), the reward formula of get_bet_reward before the payout
+ * table. All amounts up to exhaustive and random amounts up to max_amount are checked. Exit code is 2 when
+ * any reward differs by more than one unit.
+ *
+ * build:
+ *     g++ -O2 -std=c++17 -I<directory containing dice/> tools/payout_check.cpp -o payout_check
+ * run:
+ *     payout_check exhaustive=100000 random=1000000 max_amount=10000000000000
+ *
+ * parameters (amounts are in units of 0.0001 EOS):
+ *     fees                         platform fees, comma separated
+ *     max_bet_num, max_value       dice limits which define size of payout table
+ *     exhaustive                   every amount from 1 to exhaustive is checked
+ *     random                       amount of random amounts checked per fee and winners
+ *     max_amount                   upper bound of random amounts, default is about total EOS supply,
+ *                                  beyond 2^53 / 100 the floating point formula itself is not exact
+ *     seed                         seed of random amounts
+ * */
+#include <dice/rules.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Params
+{
+    std::vector<double> fees{0, 0.01, 0.015, 0.02, 0.03};
+    uint16_t max_bet_num = 100;
+    uint16_t max_value = 100;
+    int64_t exhaustive = 100000;
+    uint64_t random = 100000;
+    int64_t max_amount = 10000000000000;
+    uint64_t seed = 1;
+};
+
+bool parse_fees(const std::string& value, std::vector<double>& fees)
+{
+    fees.clear();
+    size_t pos = 0;
+    while(pos <= value.size())
+    {
+        auto end = value.find(',', pos);
+        if(end == std::string::npos)
+        {
+            end = value.size();
+        }
+        char* parsed = nullptr;
+        auto str = value.substr(pos, end - pos);
+        auto fee = std::strtod(str.c_str(), &parsed);
+        if(str.empty() || *parsed != '\0' || fee < 0 || fee >= 1)
+        {
+            return false;
+        }
+        fees.push_back(fee);
+        pos = end + 1;
+    }
+    return !fees.empty();
+}
+
+bool parse_args(int argc, char** argv, Params& params)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if(eq == std::string::npos)
+        {
+            std::fprintf(stderr, "wrong argument %s\n", argv[i]);
+            return false;
+        }
+        auto key = arg.substr(0, eq);
+        auto value = arg.substr(eq + 1);
+        const char* v = value.c_str();
+        if(key == "max_bet_num") params.max_bet_num = uint16_t(std::strtoul(v, nullptr, 10));
+        else if(key == "max_value") params.max_value = uint16_t(std::strtoul(v, nullptr, 10));
+        else if(key == "exhaustive") params.exhaustive = std::strtoll(v, nullptr, 10);
+        else if(key == "random") params.random = std::strtoull(v, nullptr, 10);
+        else if(key == "max_amount") params.max_amount = std::max(1ll, std::strtoll(v, nullptr, 10));
+        else if(key == "seed") params.seed = std::strtoull(v, nullptr, 10);
+        else if(key == "fees")
+        {
+            if(!parse_fees(value, params.fees))
+            {
+                std::fprintf(stderr, "wrong fees %s\n", v);
+                return false;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown parameter %s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Deviation
+{
+    uint64_t checked = 0;
+    uint64_t differ = 0;
+    int64_t min = 0;
+    int64_t max = 0;
+    int64_t max_amount = 0;     // amount with the biggest absolute deviation
+    size_t max_num = 0;
+
+    void add(int64_t amount, size_t num, double fee, uint64_t multiplier)
+    {
+        auto expected = int64_t(amount * (1 - fee) * (100.0 / num));
+        auto deviation = dice::rules::reward(amount, multiplier) - expected;
+        ++checked;
+        if(0 == deviation)
+        {
+            return;
+        }
+        ++differ;
+        if(std::abs(deviation) > std::max(-min, max))
+        {
+            max_amount = amount;
+            max_num = num;
+        }
+        min = std::min(min, deviation);
+        max = std::max(max, deviation);
+    }
+};
+
+}//namespace
+
+int main(int argc, char** argv)
+{
+    Params params;
+    if(!parse_args(argc, argv, params))
+    {
+        return 1;
+    }
+    std::mt19937_64 rng(params.seed);
+    std::uniform_int_distribution<int64_t> amounts(1, params.max_amount);
+    bool failed = false;
+    std::printf("%8s %12s %12s %6s %6s %18s %4s\n", "fee", "checked", "differ", "min", "max", "worst amount", "num");
+    for(auto fee: params.fees)
+    {
+        const auto multipliers = dice::rules::payout_multipliers(fee, params.max_bet_num, params.max_value);
+        Deviation deviation;
+        for(size_t num = 1; num < multipliers.size(); ++num)
+        {
+            for(int64_t amount = 1; amount <= params.exhaustive; ++amount)
+            {
+                deviation.add(amount, num, fee, multipliers[num]);
+            }
+            for(uint64_t i = 0; i < params.random; ++i)
+            {
+                deviation.add(amounts(rng), num, fee, multipliers[num]);
+            }
+        }
+        std::printf("%8.4f %12lu %12lu %6ld %6ld %18ld %4zu\n", fee, deviation.checked, deviation.differ,
+                deviation.min, deviation.max, deviation.max_amount, deviation.max_num);
+        failed = failed || deviation.min < -1 || deviation.max > 1;
+    }
+    if(failed)
+    {
+        std::fprintf(stderr, "reward differs from floating point formula by more than one unit\n");
+        return 2;
+    }
+    return 0;
+}
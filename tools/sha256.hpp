@@ -0,0 +1,340 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <immintrin.h>
+
+namespace dice {
+namespace sha256 {
+
+/*
+ * host SHA-256 for many short messages of equal length:
+ *     SCALAR - portable, one message at a time
+ *     AVX2   - eight messages in parallel, one per 32 bit lane
+ *     SHANI  - one message at a time with SHA extensions
+ * */
+enum class Kernel
+{
+    SCALAR,
+    AVX2,
+    SHANI
+};
+
+constexpr size_t digest_size = 32;
+constexpr size_t block_size = 64;
+
+namespace detail {
+
+alignas(64) constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t load_be(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline void store_be(uint8_t* p, uint32_t v)
+{
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+inline size_t padded_blocks(size_t length)
+{
+    return (length + 9 + block_size - 1) / block_size;
+}
+
+// message with SHA-256 padding, buffer must have padded_blocks(length) * block_size bytes
+inline void pad(const uint8_t* message, size_t length, uint8_t* buffer)
+{
+    auto size = padded_blocks(length) * block_size;
+    std::memcpy(buffer, message, length);
+    std::memset(buffer + length, 0, size - length);
+    buffer[length] = 0x80;
+    uint64_t bits = uint64_t(length) * 8;
+    for(int i = 0; i < 8; ++i)
+    {
+        buffer[size - 1 - i] = uint8_t(bits >> (8 * i));
+    }
+}
+
+inline void compress_scalar(uint32_t state[8], const uint8_t* block)
+{
+    uint32_t w[64];
+    for(int t = 0; t < 16; ++t)
+    {
+        w[t] = load_be(block + 4 * t);
+    }
+    for(int t = 16; t < 64; ++t)
+    {
+        uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for(int t = 0; t < 64; ++t)
+    {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+__attribute__((target("sha,sse4.1")))
+inline void compress_shani(uint32_t state[8], const uint8_t* block)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+
+    // state words are reordered to ABEF and CDGH for sha256rnds2
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    const __m128i abef = state0;
+    const __m128i cdgh = state1;
+
+    __m128i w[16];
+    for(int g = 0; g < 16; ++g)
+    {
+        if(g < 4)
+        {
+            w[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * g)), mask);
+        }
+        else
+        {
+            __m128i x = _mm_add_epi32(_mm_sha256msg1_epu32(w[g - 4], w[g - 3]), _mm_alignr_epi8(w[g - 1], w[g - 2], 4));
+            w[g] = _mm_sha256msg2_epu32(x, w[g - 1]);
+        }
+        __m128i msg = _mm_add_epi32(w[g], _mm_load_si128(reinterpret_cast<const __m128i*>(&K[4 * g])));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+    }
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#define DICE_SHA256_AVX2 __attribute__((target("avx2")))
+
+DICE_SHA256_AVX2 inline __m256i rotr8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/*
+ * compresses one block of eight messages, lane i holds message i,
+ * blocks[i] points to current block of message i
+ * */
+DICE_SHA256_AVX2 inline void compress_avx2(__m256i state[8], const uint8_t* const blocks[8])
+{
+    __m256i w[64];
+    for(int t = 0; t < 16; ++t)
+    {
+        w[t] = _mm256_setr_epi32(
+                load_be(blocks[0] + 4 * t), load_be(blocks[1] + 4 * t), load_be(blocks[2] + 4 * t),
+                load_be(blocks[3] + 4 * t), load_be(blocks[4] + 4 * t), load_be(blocks[5] + 4 * t),
+                load_be(blocks[6] + 4 * t), load_be(blocks[7] + 4 * t));
+    }
+    for(int t = 16; t < 64; ++t)
+    {
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 15], 7), rotr8(w[t - 15], 18)),
+                _mm256_srli_epi32(w[t - 15], 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[t - 2], 17), rotr8(w[t - 2], 19)),
+                _mm256_srli_epi32(w[t - 2], 10));
+        w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+    }
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for(int t = 0; t < 64; ++t)
+    {
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                _mm256_add_epi32(_mm256_add_epi32(ch, _mm256_set1_epi32(K[t])), w[t]));
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+        __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                _mm256_and_si256(b, c));
+        __m256i t2 = _mm256_add_epi32(s0, maj);
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+    state[0] = _mm256_add_epi32(state[0], a); state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c); state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e); state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g); state[7] = _mm256_add_epi32(state[7], h);
+}
+
+// eight messages starting at data with stride
+DICE_SHA256_AVX2 inline void hash8_avx2(const uint8_t* data, size_t length, size_t stride, uint8_t* out,
+        std::vector<uint8_t>& buffer)
+{
+    auto blocks = padded_blocks(length);
+    auto padded_size = blocks * block_size;
+    buffer.resize(8 * padded_size);
+    for(int lane = 0; lane < 8; ++lane)
+    {
+        pad(data + lane * stride, length, &buffer[lane * padded_size]);
+    }
+    __m256i state[8];
+    for(int i = 0; i < 8; ++i)
+    {
+        state[i] = _mm256_set1_epi32(H0[i]);
+    }
+    for(size_t block = 0; block < blocks; ++block)
+    {
+        const uint8_t* lanes[8];
+        for(int lane = 0; lane < 8; ++lane)
+        {
+            lanes[lane] = &buffer[lane * padded_size + block * block_size];
+        }
+        compress_avx2(state, lanes);
+    }
+    alignas(32) uint32_t words[8][8];
+    for(int i = 0; i < 8; ++i)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+    }
+    for(int lane = 0; lane < 8; ++lane)
+    {
+        for(int i = 0; i < 8; ++i)
+        {
+            store_be(out + lane * digest_size + 4 * i, words[i][lane]);
+        }
+    }
+}
+
+#undef DICE_SHA256_AVX2
+
+inline void hash_one(Kernel kernel, const uint8_t* message, size_t length, uint8_t* out,
+        std::vector<uint8_t>& buffer)
+{
+    auto blocks = padded_blocks(length);
+    buffer.resize(blocks * block_size);
+    pad(message, length, buffer.data());
+    uint32_t state[8];
+    std::memcpy(state, H0, sizeof(state));
+    for(size_t block = 0; block < blocks; ++block)
+    {
+        if(kernel == Kernel::SHANI)
+        {
+            compress_shani(state, &buffer[block * block_size]);
+        }
+        else
+        {
+            compress_scalar(state, &buffer[block * block_size]);
+        }
+    }
+    for(int i = 0; i < 8; ++i)
+    {
+        store_be(out + 4 * i, state[i]);
+    }
+}
+
+}//namespace detail
+
+inline bool is_supported(Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Kernel::SHANI:
+            return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        default:
+            return true;
+    }
+}
+
+// SHA extensions are faster than eight AVX2 lanes, AVX2 is faster than scalar code
+inline Kernel best_kernel()
+{
+    if(is_supported(Kernel::SHANI))
+    {
+        return Kernel::SHANI;
+    }
+    if(is_supported(Kernel::AVX2))
+    {
+        return Kernel::AVX2;
+    }
+    return Kernel::SCALAR;
+}
+
+inline const char* kernel_name(Kernel kernel)
+{
+    switch(kernel)
+    {
+        case Kernel::SHANI:
+            return "shani";
+        case Kernel::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+/*
+ * hashes count messages of length bytes, message i starts at data + i * stride,
+ * digest i is written to out + i * digest_size
+ * */
+inline void hash_many(Kernel kernel, const uint8_t* data, size_t length, size_t stride, uint8_t* out, size_t count)
+{
+    thread_local std::vector<uint8_t> buffer;
+    size_t i = 0;
+    if(kernel == Kernel::AVX2)
+    {
+        for(; i + 8 <= count; i += 8)
+        {
+            detail::hash8_avx2(data + i * stride, length, stride, out + i * digest_size, buffer);
+        }
+    }
+    for(; i < count; ++i)
+    {
+        detail::hash_one(kernel == Kernel::SHANI ? Kernel::SHANI : Kernel::SCALAR, data + i * stride, length,
+                out + i * digest_size, buffer);
+    }
+}
+
+}//namespace sha256
+}//namespace dice
@@ -0,0 +1,429 @@
+/*
+ * Monte Carlo simulator of bankroll and RTP under contract payout rules.
+ *
+ * Uses dice::rules (winners, payout table, jackpot sequence, ante bonus tiers) exactly as the contract does,
+ * every simulated path is an independent bankroll which takes bets from a population of players.
+ * Path seeds depend only on seed and path number, so results do not depend on amount of threads.
+ *
+ * build:
+ *     g++ -O2 -std=c++17 -pthread -I<directory containing dice/> tools/simulator.cpp -o simulator
+ * run:
+ *     simulator paths=1000 bets=1000000 model=random platform_fee=0.015 threads=8
+ *
+ * parameters (amounts are in EOS):
+ *     paths, bets                  amount of paths and bets per path
+ *     threads                      worker threads, default is hardware concurrency
+ *     seed                         base seed
+ *     model                        fixed | random | martingale
+ *     players                      amount of players per path
+ *     bankroll                     initial eos_balance
+ *     stake                        base bet of player
+ *     border, type                 bet of fixed and martingale models, type 1 is LEFT, 2 is RIGHT
+ *     platform_fee, max_bet_percent, jackpot_percent, balance_protect, min_bet
+ *     rare_bet_bound               upper bound of winners for rare bets
+ *     min_value, max_value, max_bet_num
+ *     tiers                        ante bonus tiers begin:end:multiplier,... (bets of player in path)
+ *     ante_in_eos
+ * */
+#include <dice/rules.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int64_t eos_precision = 10000;
+constexpr uint8_t roll_left = 1;
+constexpr uint8_t roll_right = 2;
+
+enum class Model
+{
+    FIXED,
+    RANDOM,
+    MARTINGALE
+};
+
+struct AnteTier
+{
+    uint64_t begin;
+    uint64_t end;
+    double multiplier;
+};
+
+struct Params
+{
+    uint64_t paths = 100;
+    uint64_t bets = 100000;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    Model model = Model::RANDOM;
+    uint32_t players = 100;
+    double bankroll = 10000;
+    double stake = 1;
+    uint16_t border = 50;
+    uint8_t type = roll_left;
+    double platform_fee = 0.015;
+    double max_bet_percent = 0.01;
+    double jackpot_percent = 0.005;
+    double balance_protect = 100;
+    double min_bet = 0.1;
+    uint16_t rare_bet_bound = 5;
+    uint16_t min_value = 1;
+    uint16_t max_value = 100;
+    uint16_t max_bet_num = 100;
+    double ante_in_eos = 1;
+    std::vector<AnteTier> tiers;
+};
+
+struct Totals
+{
+    uint64_t bets = 0;
+    uint64_t rejected = 0;
+    uint64_t wins = 0;
+    uint64_t rare = 0;
+    uint64_t jackpots = 0;
+    uint64_t stopped_paths = 0;
+    int64_t bet_amount = 0;
+    int64_t payout = 0;
+    int64_t jackpot_payout = 0;
+    double ante_minted = 0;
+
+    void add(const Totals& other)
+    {
+        bets += other.bets;
+        rejected += other.rejected;
+        wins += other.wins;
+        rare += other.rare;
+        jackpots += other.jackpots;
+        stopped_paths += other.stopped_paths;
+        bet_amount += other.bet_amount;
+        payout += other.payout;
+        jackpot_payout += other.jackpot_payout;
+        ante_minted += other.ante_minted;
+    }
+};
+
+// xoshiro256** seeded by splitmix64
+class Rng
+{
+public:
+    explicit Rng(uint64_t seed)
+    {
+        for(auto& word: _state)
+        {
+            seed += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next()
+    {
+        const uint64_t result = rotl(_state[1] * 5, 7) * 9;
+        const uint64_t t = _state[1] << 17;
+        _state[2] ^= _state[0];
+        _state[3] ^= _state[1];
+        _state[1] ^= _state[2];
+        _state[0] ^= _state[3];
+        _state[2] ^= t;
+        _state[3] = rotl(_state[3], 45);
+        return result;
+    }
+
+    // unbiased value ranged [0, max-1], same rejection rule as common::random::stream
+    uint64_t next(uint64_t max)
+    {
+        if(max <= 1)
+        {
+            return 0;
+        }
+        const uint64_t rest = (UINT64_MAX % max + 1) % max;
+        uint64_t r = next();
+        while(r > UINT64_MAX - rest)
+        {
+            r = next();
+        }
+        return r % max;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t _state[4];
+};
+
+struct Player
+{
+    int jackpot_sequence = -1;
+    std::string jackpot_sequence_values;
+    uint64_t bets = 0;
+    int64_t next_stake = 0;
+};
+
+struct PathResult
+{
+    Totals totals;
+    double max_drawdown = 0;      // part of initial bankroll
+};
+
+int64_t to_amount(double eos)
+{
+    return int64_t(std::llround(eos * eos_precision));
+}
+
+PathResult run_path(const Params& params, const std::vector<uint64_t>& multipliers, uint64_t path)
+{
+    Rng rng(params.seed * 0x100000001b3ull ^ path);
+    PathResult result;
+    auto& totals = result.totals;
+
+    const int64_t stake = to_amount(params.stake);
+    const int64_t min_bet = to_amount(params.min_bet);
+    const int64_t protect = to_amount(params.balance_protect);
+    int64_t balance = to_amount(params.bankroll);
+    int64_t jackpot_balance = 0;
+    int64_t peak = balance;
+
+    std::vector<Player> players(params.players);
+    for(auto& player: players)
+    {
+        player.next_stake = stake;
+    }
+
+    for(uint64_t i = 0; i < params.bets; ++i)
+    {
+        auto& player = players[rng.next(players.size())];
+
+        uint8_t type = params.type;
+        uint16_t border = params.border;
+        int64_t quantity = stake;
+        if(params.model == Model::RANDOM)
+        {
+            type = rng.next(2) ? roll_left : roll_right;
+            // borders which leave between 1 and 96 winning values
+            auto num = 1 + rng.next(96);
+            border = type == roll_left ? num : params.max_bet_num - 1 - num;
+            quantity = stake * int64_t(1 + rng.next(10));
+        }
+        else if(params.model == Model::MARTINGALE)
+        {
+            quantity = player.next_stake;
+        }
+
+        // checks of on_bet
+        balance += quantity;
+        if(balance < protect)
+        {
+            balance -= quantity;
+            ++totals.stopped_paths;
+            break;
+        }
+        bool is_left = type == roll_left;
+        auto num = dice::rules::winners(is_left, border, params.max_bet_num);
+        bool valid_border = is_left ? border <= params.max_value : border >= params.min_value;
+        bool valid = valid_border && num != 0 && num < multipliers.size() && quantity >= min_bet &&
+                quantity <= balance * params.max_bet_percent &&
+                dice::rules::reward(quantity, multipliers[num]) <= balance * params.max_bet_percent;
+        if(!valid)
+        {
+            balance -= quantity;
+            ++totals.rejected;
+            player.next_stake = stake;
+            continue;
+        }
+
+        // resolution
+        ++totals.bets;
+        totals.bet_amount += quantity;
+        auto roll_value = rng.next(params.max_value);
+        if(dice::rules::is_win(is_left, border, roll_value))
+        {
+            auto reward = dice::rules::reward(quantity, multipliers[num]);
+            balance -= reward;
+            totals.payout += reward;
+            ++totals.wins;
+            if(num <= params.rare_bet_bound)
+            {
+                ++totals.rare;
+            }
+            player.next_stake = stake;
+        }
+        else
+        {
+            player.next_stake = quantity * 2;
+        }
+
+        jackpot_balance += quantity * params.jackpot_percent;
+        if(dice::rules::jackpot_step(player.jackpot_sequence, player.jackpot_sequence_values, roll_value))
+        {
+            ++totals.jackpots;
+            balance -= jackpot_balance;
+            totals.jackpot_payout += jackpot_balance;
+            jackpot_balance = 0;
+        }
+
+        ++player.bets;
+        auto multiplier = dice::rules::bonus_multiplier(params.tiers.begin(), params.tiers.end(), player.bets);
+        totals.ante_minted += double(quantity) / eos_precision / params.ante_in_eos * multiplier;
+
+        peak = std::max(peak, balance);
+        result.max_drawdown = std::max(result.max_drawdown, double(peak - balance) / to_amount(params.bankroll));
+    }
+    return result;
+}
+
+bool parse_tiers(const std::string& str, std::vector<AnteTier>& tiers)
+{
+    size_t pos = 0;
+    while(pos < str.size())
+    {
+        auto end = str.find(',', pos);
+        auto item = str.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        AnteTier tier;
+        if(3 != std::sscanf(item.c_str(), "%lu:%lu:%lf", &tier.begin, &tier.end, &tier.multiplier))
+        {
+            return false;
+        }
+        tiers.push_back(tier);
+        pos = end == std::string::npos ? str.size() : end + 1;
+    }
+    std::sort(tiers.begin(), tiers.end(), [](const auto& lhs, const auto& rhs) { return lhs.begin < rhs.begin; });
+    return true;
+}
+
+bool parse_args(int argc, char** argv, Params& params)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if(eq == std::string::npos)
+        {
+            std::fprintf(stderr, "wrong argument %s\n", argv[i]);
+            return false;
+        }
+        auto key = arg.substr(0, eq);
+        auto value = arg.substr(eq + 1);
+        const char* v = value.c_str();
+        if(key == "paths") params.paths = std::strtoull(v, nullptr, 10);
+        else if(key == "bets") params.bets = std::strtoull(v, nullptr, 10);
+        else if(key == "threads") params.threads = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "seed") params.seed = std::strtoull(v, nullptr, 10);
+        else if(key == "players") params.players = std::max(1ul, std::strtoul(v, nullptr, 10));
+        else if(key == "bankroll") params.bankroll = std::atof(v);
+        else if(key == "stake") params.stake = std::atof(v);
+        else if(key == "border") params.border = std::atoi(v);
+        else if(key == "type") params.type = std::atoi(v) == roll_right ? roll_right : roll_left;
+        else if(key == "platform_fee") params.platform_fee = std::atof(v);
+        else if(key == "max_bet_percent") params.max_bet_percent = std::atof(v);
+        else if(key == "jackpot_percent") params.jackpot_percent = std::atof(v);
+        else if(key == "balance_protect") params.balance_protect = std::atof(v);
+        else if(key == "min_bet") params.min_bet = std::atof(v);
+        else if(key == "rare_bet_bound") params.rare_bet_bound = std::atoi(v);
+        else if(key == "min_value") params.min_value = std::atoi(v);
+        else if(key == "max_value") params.max_value = std::atoi(v);
+        else if(key == "max_bet_num") params.max_bet_num = std::atoi(v);
+        else if(key == "ante_in_eos") params.ante_in_eos = std::atof(v);
+        else if(key == "tiers")
+        {
+            if(!parse_tiers(value, params.tiers))
+            {
+                std::fprintf(stderr, "wrong tiers %s\n", v);
+                return false;
+            }
+        }
+        else if(key == "model")
+        {
+            if(value == "fixed") params.model = Model::FIXED;
+            else if(value == "random") params.model = Model::RANDOM;
+            else if(value == "martingale") params.model = Model::MARTINGALE;
+            else
+            {
+                std::fprintf(stderr, "wrong model %s\n", v);
+                return false;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "unknown parameter %s\n", key.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if(sorted.empty())
+    {
+        return 0;
+    }
+    auto index = size_t(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Params params;
+    if(!parse_args(argc, argv, params))
+    {
+        return 1;
+    }
+    const auto multipliers = dice::rules::payout_multipliers(params.platform_fee, params.max_bet_num,
+            params.max_value);
+
+    std::vector<PathResult> results(params.paths);
+    std::atomic<uint64_t> next_path{0};
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < params.threads; ++t)
+    {
+        workers.emplace_back([&]()
+        {
+            for(auto path = next_path++; path < params.paths; path = next_path++)
+            {
+                results[path] = run_path(params, multipliers, path);
+            }
+        });
+    }
+    for(auto& worker: workers)
+    {
+        worker.join();
+    }
+
+    Totals totals;
+    std::vector<double> drawdowns;
+    drawdowns.reserve(results.size());
+    for(const auto& result: results)
+    {
+        totals.add(result.totals);
+        drawdowns.push_back(result.max_drawdown);
+    }
+    std::sort(drawdowns.begin(), drawdowns.end());
+
+    auto bet_amount = double(totals.bet_amount);
+    std::printf("paths=%lu bets=%lu rejected=%lu stopped_paths=%lu\n",
+            params.paths, totals.bets, totals.rejected, totals.stopped_paths);
+    std::printf("rtp=%.6f rtp_with_jackpot=%.6f win_rate=%.6f rare_wins=%lu\n",
+            totals.payout / bet_amount, (totals.payout + totals.jackpot_payout) / bet_amount,
+            double(totals.wins) / totals.bets, totals.rare);
+    std::printf("jackpots=%lu jackpots_per_million_bets=%.3f jackpot_payout=%.4f\n",
+            totals.jackpots, totals.jackpots * 1e6 / totals.bets, double(totals.jackpot_payout) / eos_precision);
+    std::printf("drawdown p50=%.4f p90=%.4f p99=%.4f max=%.4f\n",
+            percentile(drawdowns, 0.5), percentile(drawdowns, 0.9), percentile(drawdowns, 0.99),
+            drawdowns.empty() ? 0.0 : drawdowns.back());
+    std::printf("ante_per_eos=%.6f\n", totals.ante_minted / (bet_amount / eos_precision));
+    return 0;
+}
@@ -0,0 +1,427 @@
+/*
+ * Batch provably-fair verifier of exported bet history.
+ *
+ * Recomputes rolls of bets from seeds stored in bets.all and, when seeds of generator are known,
+ * the stored seed itself, hashing many records at once with multi-buffer SHA-256 on all threads.
+ * Rolls of stream are recomputed from the block of the recorded word, so the exact word is checked.
+ *
+ * build:
+ *     g++ -O2 -std=c++17 -pthread tools/verifier.cpp -o verifier
+ * run:
+ *     verifier [kernel=scalar|avx2|shani] [threads=N] [file]    (reads stdin when file is omitted)
+ *
+ * input is one bet per line, fields are separated by spaces, hex values are 64 digits, '#' starts comment:
+ *     id g max roll seed [sys_seed user_seed [commitment]]
+ *     id s max roll seed seed_word [sys_seed user_seed [commitment]]
+ *         g, s        roll of common::random::generator, roll of common::random::stream
+ *         max         max value passed to generator, ie max_value of dice limits
+ *         roll        stored roll_value
+ *         seed        stored seed, seed of stream for s
+ *         seed_word   stored seed_word, index of stream word which produced roll + 1
+ *         sys_seed    system seed of generator, house seed for bets of REVEAL and BATCH modes
+ *         user_seed   user seed of generator, transaction hash of bet
+ *         commitment  house commitment of REVEAL mode bet, sha256(sys_seed)
+ * checks:
+ *     g: roll == second 64 bit word of seed % max,
+ *        seed == sha256(mixed, mixed) where mixed == sha256(sys_seed, user_seed)
+ *     s: roll == word w % 4 of sha256(seed, w / 4 as 64 bit little endian) % max where w == seed_word - 1,
+ *        the word is not rejected by stream, seed == sha256(sys_seed, user_seed)
+ *     commitment == sha256(sys_seed)
+ * every failed check is printed as "MISMATCH id reason", exit code is 1 when there are mismatches
+ * */
+#include "sha256.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Digest = std::array<uint8_t, dice::sha256::digest_size>;
+
+struct Record
+{
+    uint64_t id;
+    char kind;
+    uint64_t max;
+    uint64_t roll;
+    Digest seed;
+    uint64_t seed_word;
+    bool has_seeds;
+    bool has_commitment;
+    Digest sys_seed;
+    Digest user_seed;
+    Digest commitment;
+};
+
+struct Mismatch
+{
+    size_t index;
+    const char* reason;
+};
+
+struct Stats
+{
+    uint64_t verified = 0;
+    uint64_t hashes = 0;
+};
+
+bool parse_hex(const std::string& str, Digest& digest)
+{
+    if(str.size() != 2 * digest.size())
+    {
+        return false;
+    }
+    auto value = [](char c) -> int
+    {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for(size_t i = 0; i < digest.size(); ++i)
+    {
+        int hi = value(str[2 * i]);
+        int lo = value(str[2 * i + 1]);
+        if(hi < 0 || lo < 0)
+        {
+            return false;
+        }
+        digest[i] = uint8_t(hi << 4 | lo);
+    }
+    return true;
+}
+
+bool parse_record(const std::string& line, Record& record)
+{
+    char kind[2] = {};
+    char seed[80] = {}, sys_seed[80] = {}, user_seed[80] = {}, commitment[80] = {};
+    unsigned long long id = 0, max = 0, roll = 0, seed_word = 0;
+    int consumed = 0;
+    if(std::sscanf(line.c_str(), "%llu %1s %llu %llu %79s%n", &id, kind, &max, &roll, seed, &consumed) != 5)
+    {
+        return false;
+    }
+    const char* rest = line.c_str() + consumed;
+    if(kind[0] == 's')
+    {
+        int word_consumed = 0;
+        if(std::sscanf(rest, "%llu%n", &seed_word, &word_consumed) != 1 || seed_word == 0)
+        {
+            return false;
+        }
+        rest += word_consumed;
+    }
+    else if(kind[0] != 'g')
+    {
+        return false;
+    }
+    int fields = std::sscanf(rest, "%79s %79s %79s", sys_seed, user_seed, commitment);
+    if(fields != EOF && fields != 0 && fields != 2 && fields != 3)
+    {
+        return false;
+    }
+    record.id = id;
+    record.kind = kind[0];
+    record.max = max;
+    record.roll = roll;
+    record.seed_word = seed_word;
+    record.has_seeds = fields >= 2;
+    record.has_commitment = fields == 3;
+    return parse_hex(seed, record.seed) &&
+           (!record.has_seeds || (parse_hex(sys_seed, record.sys_seed) && parse_hex(user_seed, record.user_seed))) &&
+           (!record.has_commitment || parse_hex(commitment, record.commitment));
+}
+
+// 64 bit word of checksum as it is read by contract (little endian)
+uint64_t word(const Digest& digest, int index)
+{
+    uint64_t value;
+    std::memcpy(&value, digest.data() + 8 * index, sizeof(value));
+    return value;
+}
+
+// roll of generator, roll of stream with max <= 1 which takes no words
+bool check_roll(const Record& record)
+{
+    if(record.kind == 'g')
+    {
+        return record.roll == (record.max == 0 ? 0 : word(record.seed, 1) % record.max);
+    }
+    return record.roll == 0;
+}
+
+// roll of stream from block of its word
+bool check_stream_roll(const Record& record, const uint8_t* block)
+{
+    constexpr uint64_t words = dice::sha256::digest_size / sizeof(uint64_t);
+    Digest digest;
+    std::memcpy(digest.data(), block, digest.size());
+    auto value = word(digest, int((record.seed_word - 1) % words));
+    // values above the last complete range of max numbers are rejected by stream
+    const uint64_t rest = (std::numeric_limits<uint64_t>::max() % record.max + 1) % record.max;
+    return value <= std::numeric_limits<uint64_t>::max() - rest && value % record.max == record.roll;
+}
+
+// input of stream block which contains word: seed followed by block number as 64 bit little endian
+void stream_block_input(const Record& record, uint8_t* input)
+{
+    constexpr uint64_t words = dice::sha256::digest_size / sizeof(uint64_t);
+    const uint64_t counter = (record.seed_word - 1) / words;
+    std::memcpy(input, record.seed.data(), dice::sha256::digest_size);
+    for(size_t i = 0; i < sizeof(counter); ++i)
+    {
+        input[dice::sha256::digest_size + i] = uint8_t(counter >> (8 * i));
+    }
+}
+
+/*
+ * verifies records [begin, end) in batches, each hashing step of a batch is one hash_many call
+ * */
+void verify(dice::sha256::Kernel kernel, const std::vector<Record>& records, size_t begin, size_t end,
+        std::vector<Mismatch>& mismatches, Stats& stats)
+{
+    constexpr size_t batch_size = 1024;
+    std::vector<size_t> streamed;
+    std::vector<size_t> seeded;
+    std::vector<size_t> mixed_seeded;
+    std::vector<size_t> committed;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> mixed;
+    std::vector<uint8_t> output;
+    for(size_t batch = begin; batch < end; batch += batch_size)
+    {
+        auto batch_end = std::min(end, batch + batch_size);
+        streamed.clear();
+        seeded.clear();
+        mixed_seeded.clear();
+        committed.clear();
+        for(size_t i = batch; i < batch_end; ++i)
+        {
+            const auto& record = records[i];
+            ++stats.verified;
+            if(record.kind == 's' && record.max > 1)
+            {
+                streamed.push_back(i);
+            }
+            else if(!check_roll(record))
+            {
+                mismatches.push_back(Mismatch{i, "roll"});
+            }
+            if(record.has_seeds)
+            {
+                (record.kind == 'g' ? seeded : mixed_seeded).push_back(i);
+            }
+            if(record.has_commitment)
+            {
+                committed.push_back(i);
+            }
+        }
+
+        // word of stream block sha256(seed, counter)
+        const size_t block_input_size = dice::sha256::digest_size + sizeof(uint64_t);
+        input.resize(streamed.size() * block_input_size);
+        output.resize(streamed.size() * dice::sha256::digest_size);
+        for(size_t k = 0; k < streamed.size(); ++k)
+        {
+            stream_block_input(records[streamed[k]], &input[k * block_input_size]);
+        }
+        dice::sha256::hash_many(kernel, input.data(), block_input_size, block_input_size, output.data(),
+                streamed.size());
+        stats.hashes += streamed.size();
+        for(size_t k = 0; k < streamed.size(); ++k)
+        {
+            if(!check_stream_roll(records[streamed[k]], &output[k * dice::sha256::digest_size]))
+            {
+                mismatches.push_back(Mismatch{streamed[k], "roll"});
+            }
+        }
+
+        // seed of stream == sha256(sys_seed, user_seed)
+        const size_t pair_size = 2 * dice::sha256::digest_size;
+        input.resize(mixed_seeded.size() * pair_size);
+        output.resize(mixed_seeded.size() * dice::sha256::digest_size);
+        for(size_t k = 0; k < mixed_seeded.size(); ++k)
+        {
+            const auto& record = records[mixed_seeded[k]];
+            std::memcpy(&input[k * pair_size], record.sys_seed.data(), dice::sha256::digest_size);
+            std::memcpy(&input[k * pair_size + dice::sha256::digest_size], record.user_seed.data(),
+                    dice::sha256::digest_size);
+        }
+        dice::sha256::hash_many(kernel, input.data(), pair_size, pair_size, output.data(), mixed_seeded.size());
+        stats.hashes += mixed_seeded.size();
+        for(size_t k = 0; k < mixed_seeded.size(); ++k)
+        {
+            const auto& record = records[mixed_seeded[k]];
+            if(0 != std::memcmp(&output[k * dice::sha256::digest_size], record.seed.data(), dice::sha256::digest_size))
+            {
+                mismatches.push_back(Mismatch{mixed_seeded[k], "seed"});
+            }
+        }
+
+        // seed == sha256(mixed, mixed), mixed == sha256(sys_seed, user_seed)
+        input.resize(seeded.size() * pair_size);
+        mixed.resize(seeded.size() * pair_size);
+        for(size_t k = 0; k < seeded.size(); ++k)
+        {
+            const auto& record = records[seeded[k]];
+            std::memcpy(&input[k * pair_size], record.sys_seed.data(), dice::sha256::digest_size);
+            std::memcpy(&input[k * pair_size + dice::sha256::digest_size], record.user_seed.data(),
+                    dice::sha256::digest_size);
+        }
+        // every mixed digest is written twice to get (mixed, mixed)
+        output.resize(seeded.size() * dice::sha256::digest_size);
+        dice::sha256::hash_many(kernel, input.data(), pair_size, pair_size, output.data(), seeded.size());
+        for(size_t k = 0; k < seeded.size(); ++k)
+        {
+            std::memcpy(&mixed[k * pair_size], &output[k * dice::sha256::digest_size], dice::sha256::digest_size);
+            std::memcpy(&mixed[k * pair_size + dice::sha256::digest_size], &output[k * dice::sha256::digest_size],
+                    dice::sha256::digest_size);
+        }
+        dice::sha256::hash_many(kernel, mixed.data(), pair_size, pair_size, output.data(), seeded.size());
+        stats.hashes += 2 * seeded.size();
+        for(size_t k = 0; k < seeded.size(); ++k)
+        {
+            const auto& record = records[seeded[k]];
+            if(0 != std::memcmp(&output[k * dice::sha256::digest_size], record.seed.data(), dice::sha256::digest_size))
+            {
+                mismatches.push_back(Mismatch{seeded[k], "seed"});
+            }
+        }
+
+        // commitment == sha256(sys_seed)
+        input.resize(committed.size() * dice::sha256::digest_size);
+        output.resize(committed.size() * dice::sha256::digest_size);
+        for(size_t k = 0; k < committed.size(); ++k)
+        {
+            std::memcpy(&input[k * dice::sha256::digest_size], records[committed[k]].sys_seed.data(),
+                    dice::sha256::digest_size);
+        }
+        dice::sha256::hash_many(kernel, input.data(), dice::sha256::digest_size, dice::sha256::digest_size,
+                output.data(), committed.size());
+        stats.hashes += committed.size();
+        for(size_t k = 0; k < committed.size(); ++k)
+        {
+            const auto& record = records[committed[k]];
+            if(0 != std::memcmp(&output[k * dice::sha256::digest_size], record.commitment.data(),
+                    dice::sha256::digest_size))
+            {
+                mismatches.push_back(Mismatch{committed[k], "commitment"});
+            }
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    auto kernel = dice::sha256::best_kernel();
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const char* path = nullptr;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg.rfind("kernel=", 0) == 0)
+        {
+            auto name = arg.substr(7);
+            if(name == "scalar") kernel = dice::sha256::Kernel::SCALAR;
+            else if(name == "avx2") kernel = dice::sha256::Kernel::AVX2;
+            else if(name == "shani") kernel = dice::sha256::Kernel::SHANI;
+            else
+            {
+                std::fprintf(stderr, "unknown kernel %s\n", name.c_str());
+                return 2;
+            }
+            if(!dice::sha256::is_supported(kernel))
+            {
+                std::fprintf(stderr, "kernel %s is not supported by cpu\n", name.c_str());
+                return 2;
+            }
+        }
+        else if(arg.rfind("threads=", 0) == 0)
+        {
+            threads = std::max(1, std::atoi(arg.c_str() + 8));
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    std::ifstream file;
+    if(path)
+    {
+        file.open(path);
+        if(!file)
+        {
+            std::fprintf(stderr, "cannot open %s\n", path);
+            return 2;
+        }
+    }
+    std::istream& in = path ? file : std::cin;
+
+    std::vector<Record> records;
+    std::string line;
+    uint64_t line_number = 0;
+    while(std::getline(in, line))
+    {
+        ++line_number;
+        auto start = line.find_first_not_of(" \t\r");
+        if(start == std::string::npos || line[start] == '#')
+        {
+            continue;
+        }
+        Record record;
+        if(!parse_record(line, record))
+        {
+            std::fprintf(stderr, "wrong record at line %llu\n", (unsigned long long)line_number);
+            return 2;
+        }
+        records.push_back(record);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    threads = std::max<size_t>(1, std::min<size_t>(threads, records.size()));
+    std::vector<std::vector<Mismatch>> mismatches(threads);
+    std::vector<Stats> stats(threads);
+    std::vector<std::thread> workers;
+    size_t chunk = (records.size() + threads - 1) / threads;
+    for(unsigned t = 0; t < threads; ++t)
+    {
+        size_t begin = std::min(records.size(), t * chunk);
+        size_t end = std::min(records.size(), begin + chunk);
+        workers.emplace_back(verify, kernel, std::cref(records), begin, end, std::ref(mismatches[t]),
+                std::ref(stats[t]));
+    }
+    for(auto& worker: workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    Stats total;
+    std::vector<Mismatch> all;
+    for(unsigned t = 0; t < threads; ++t)
+    {
+        total.verified += stats[t].verified;
+        total.hashes += stats[t].hashes;
+        all.insert(all.end(), mismatches[t].begin(), mismatches[t].end());
+    }
+    std::sort(all.begin(), all.end(), [](const auto& lhs, const auto& rhs) { return lhs.index < rhs.index; });
+    for(const auto& mismatch: all)
+    {
+        std::printf("MISMATCH %llu %s\n", (unsigned long long)records[mismatch.index].id, mismatch.reason);
+    }
+    std::printf("records=%llu hashes=%llu mismatches=%zu kernel=%s threads=%u seconds=%.3f\n",
+            (unsigned long long)total.verified, (unsigned long long)total.hashes, all.size(),
+            dice::sha256::kernel_name(kernel), threads, seconds);
+    return all.empty() ? 0 : 1;
+}